@@ -0,0 +1,26 @@
+#include "BallTrail.hpp"
+
+BallTrail::BallTrail(float length_) : length(length_), spacing(length_ / float(Capacity - 2)) {
+}
+
+void BallTrail::reset(glm::vec2 const &position, float time) {
+	written = 0;
+	push(position, time - length);
+	push(position, time);
+}
+
+void BallTrail::push(glm::vec2 const &position, float time) {
+	//newest sample still too close to the one before it? move it up to this one instead:
+	// (so every sample but the newest is at least 'spacing' after its predecessor)
+	Sample &newest = samples[(written - 1) % Capacity];
+	if (written >= 2 && newest.time - at(written - 2).time < spacing) {
+		newest.position = position;
+		newest.time = time;
+		return;
+	}
+	Sample &sample = samples[written % Capacity];
+	sample.position = position;
+	sample.time = time;
+	sample.unused = 0.0f;
+	written += 1;
+}
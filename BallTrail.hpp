@@ -0,0 +1,52 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+/*
+ * BallTrail remembers where the ball has been, as (position, time) samples in
+ *  a fixed-capacity ring. Each sample keeps the absolute (sim) time it was
+ *  taken at, so nothing has to be aged as time passes -- a sample's age is just
+ *  'now - time' whenever someone needs it -- and the oldest samples are simply
+ *  overwritten.
+ *
+ * Samples are kept at least 'spacing' seconds apart: while the newest sample is
+ *  closer than that to the one before it, push() moves it instead of adding one.
+ *  With spacing = length / (Capacity - 2), the ring always reaches back at
+ *  least 'length' seconds, however short the ticks are.
+ *
+ * Sample is laid out as one RGBA32F texel (x, y, time, unused), so the renderer
+ *  can copy samples straight out of the ring (see TrailProgram).
+ */
+
+struct BallTrail {
+	static constexpr uint32_t Capacity = 128;
+	static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two (so 'written' may wrap)");
+
+	struct Sample {
+		glm::vec2 position;
+		float time;
+		float unused;
+	};
+	static_assert(sizeof(Sample) == 4*4, "Sample should be packed");
+
+	BallTrail(float length);
+
+	//forget all samples, and act as if the ball has been at 'position' since 'time - length':
+	void reset(glm::vec2 const &position, float time);
+
+	//record the ball at 'position' at 'time' (times must not decrease):
+	void push(glm::vec2 const &position, float time);
+
+	float length; //how far back (in seconds) the trail is drawn
+	float spacing; //minimum time between samples
+
+	Sample samples[Capacity];
+	uint32_t written = 0; //samples ever added; the newest is samples[(written-1) % Capacity]
+
+	uint32_t size() const { return written < Capacity ? written : Capacity; }
+	//samples [first(), written) are valid; index them with at():
+	uint32_t first() const { return written - size(); }
+	Sample const &at(uint32_t index) const { return samples[index % Capacity]; }
+};
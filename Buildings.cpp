@@ -0,0 +1,80 @@
+#include "Buildings.hpp"
+
+#include <cassert>
+
+BuildingHandle Buildings::create(glm::vec2 const &position, int type) {
+	uint32_t slot;
+	if (!free_slots.empty()) {
+		slot = free_slots.back();
+		free_slots.pop_back();
+	} else {
+		slot = uint32_t(slots.size());
+		slots.emplace_back();
+	}
+
+	BuildingHandle handle;
+	handle.slot = slot;
+	handle.generation = slots[slot].generation;
+
+	slots[slot].index = uint32_t(positions.size());
+	positions.emplace_back(position);
+	types.emplace_back(type);
+	dying.emplace_back(0);
+	handles.emplace_back(handle);
+
+	if (log_changes) changed_slots.emplace_back(slot);
+
+	return handle;
+}
+
+void Buildings::destroy(BuildingHandle const &handle) {
+	if (!valid(handle)) return;
+	uint32_t i = index(handle);
+	if (dying[i]) return;
+	dying[i] = 1;
+	doomed.emplace_back(handle);
+}
+
+void Buildings::flush() {
+	for (auto const &handle : doomed) {
+		assert(valid(handle));
+		uint32_t i = index(handle);
+		uint32_t last = uint32_t(positions.size()) - 1;
+
+		//move last building into the hole:
+		if (i != last) {
+			positions[i] = positions[last];
+			types[i] = types[last];
+			dying[i] = dying[last];
+			handles[i] = handles[last];
+			slots[handles[i].slot].index = i;
+		}
+		positions.pop_back();
+		types.pop_back();
+		dying.pop_back();
+		handles.pop_back();
+
+		//free the slot (bumping generation so old handles go stale):
+		slots[handle.slot].index = -1U;
+		slots[handle.slot].generation += 1;
+		free_slots.emplace_back(handle.slot);
+
+		if (log_changes) changed_slots.emplace_back(handle.slot);
+	}
+	doomed.clear();
+}
+
+void Buildings::clear() {
+	for (auto const &handle : handles) {
+		slots[handle.slot].index = -1U;
+		slots[handle.slot].generation += 1;
+		free_slots.emplace_back(handle.slot);
+
+		if (log_changes) changed_slots.emplace_back(handle.slot);
+	}
+	positions.clear();
+	types.clear();
+	dying.clear();
+	handles.clear();
+	doomed.clear();
+}
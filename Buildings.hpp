@@ -0,0 +1,73 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * Buildings stores every building in the match as a structure of arrays.
+ *
+ * Buildings live at a dense index (which changes when others are removed,
+ *  since removal is swap-and-pop) and are referred to from outside by a
+ *  BuildingHandle (which stays valid until the building is removed, and is
+ *  never reused for a different building thanks to its generation count).
+ *
+ * destroy() only marks a building as dying; dying buildings stay in the
+ *  arrays (so loops over dense indices are not disturbed) until flush()
+ *  removes them, which PongSim does at the end of every tick.
+ */
+
+struct BuildingHandle {
+	uint32_t slot = -1U;
+	uint32_t generation = 0;
+
+	bool operator==(BuildingHandle const &o) const { return slot == o.slot && generation == o.generation; }
+	bool operator!=(BuildingHandle const &o) const { return !(*this == o); }
+};
+
+struct Buildings {
+	//----- dense storage (index i in each array refers to the same building) -----
+	std::vector< glm::vec2 > positions;
+	std::vector< int > types;
+	std::vector< uint8_t > dying; //non-zero once destroy() has been called
+	std::vector< BuildingHandle > handles; //handle of the building at each dense index
+
+	size_t size() const { return positions.size(); }
+
+	//add a building; returns its handle:
+	BuildingHandle create(glm::vec2 const &position, int type);
+
+	//does the handle refer to a building that is still stored (possibly dying)?
+	bool valid(BuildingHandle const &handle) const {
+		return handle.slot < slots.size() && slots[handle.slot].generation == handle.generation && slots[handle.slot].index != -1U;
+	}
+
+	//dense index of a valid handle:
+	uint32_t index(BuildingHandle const &handle) const { return slots[handle.slot].index; }
+
+	//mark a building for removal at the next flush() (repeated calls are fine):
+	void destroy(BuildingHandle const &handle);
+	void destroy_at(uint32_t index) { destroy(handles[index]); }
+
+	//remove all dying buildings (swap-and-pop; changes dense indices):
+	void flush();
+
+	//remove everything (invalidates all handles):
+	void clear();
+
+	//----- change log -----
+	//if enabled, the slot of every building added by create() or removed by flush()/clear() is appended
+	// to 'changed_slots' (e.g., so a renderer can patch just those buildings); the reader clears it:
+	bool log_changes = false;
+	std::vector< uint32_t > changed_slots;
+
+	//----- handle bookkeeping -----
+	struct Slot {
+		uint32_t index = -1U; //dense index, or -1U if slot is free
+		uint32_t generation = 0; //bumped every time the slot is freed
+	};
+	std::vector< Slot > slots;
+	std::vector< uint32_t > free_slots;
+	std::vector< BuildingHandle > doomed; //handles passed to destroy() since the last flush()
+};
@@ -0,0 +1,45 @@
+#include "Bullets.hpp"
+
+Bullets::Bullets(uint32_t capacity) :
+	x(capacity, 0.0f), y(capacity, 0.0f), direction(capacity, 0.0f), owner(capacity, 0), dead(capacity, 0) {
+}
+
+bool Bullets::spawn(glm::vec2 const &position, int side) {
+	if (count == capacity()) {
+		++dropped;
+		return false;
+	}
+	x[count] = position.x;
+	y[count] = position.y;
+	direction[count] = (side > 0 ? 1.0f : -1.0f);
+	owner[count] = int8_t(side);
+	dead[count] = 0;
+	++count;
+	return true;
+}
+
+void Bullets::move(float distance) {
+	//plain arrays + no branches so the compiler can vectorize this loop:
+	float *__restrict xs = x.data();
+	float const *__restrict ds = direction.data();
+	uint32_t n = count;
+	for (uint32_t i = 0; i < n; ++i) {
+		xs[i] += ds[i] * distance;
+	}
+}
+
+void Bullets::compact() {
+	uint32_t out = 0;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (dead[i]) continue;
+		if (out != i) {
+			x[out] = x[i];
+			y[out] = y[i];
+			direction[out] = direction[i];
+			owner[out] = owner[i];
+			dead[out] = 0;
+		}
+		++out;
+	}
+	count = out;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * Bullets is a fixed-capacity pool of bullets stored as a structure of arrays.
+ *
+ * During a tick, bullets that hit something are only marked dead (so indices
+ *  stay put while collision loops run); compact() then removes all dead
+ *  bullets in one pass at the end of the tick.
+ */
+
+struct Bullets {
+	Bullets(uint32_t capacity = 4096);
+
+	uint32_t count = 0; //bullets [0,count) are in use
+	uint32_t capacity() const { return uint32_t(x.size()); }
+
+	std::vector< float > x;
+	std::vector< float > y;
+	std::vector< float > direction; //+1.0f moves right, -1.0f moves left
+	std::vector< int8_t > owner; //SIDE_LEFT or SIDE_RIGHT
+	std::vector< uint8_t > dead; //non-zero once kill()'d
+
+	//spawns dropped because the pool was full:
+	uint32_t dropped = 0;
+
+	//add a bullet owned by 'side' (it travels away from that side); returns false if pool is full:
+	bool spawn(glm::vec2 const &position, int side);
+
+	glm::vec2 position(uint32_t i) const { return glm::vec2(x[i], y[i]); }
+
+	//move every bullet 'distance' along its direction:
+	void move(float distance);
+
+	void kill(uint32_t i) { dead[i] = 1; }
+
+	//remove dead bullets (changes indices):
+	void compact();
+
+	void clear() { count = 0; }
+};
@@ -0,0 +1,290 @@
+#include "DrawList.hpp"
+
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+DrawList::DrawList(std::shared_ptr< RectInstanceProgram const > const &program_, StreamBuffer::Method method)
+	: program(program_), stream(method, sizeof(RectInstance)) {
+	for (uint32_t l = 0; l < LayerCount; ++l) {
+		open_run[l] = -1U;
+	}
+
+	{ //unit quad buffer:
+		//every rectangle is this quad, scaled by its radius and moved to its center (as two CCW-oriented triangles):
+		std::vector< glm::vec2 > corners{
+			glm::vec2(-1.0f,-1.0f), glm::vec2( 1.0f,-1.0f), glm::vec2( 1.0f, 1.0f),
+			glm::vec2(-1.0f,-1.0f), glm::vec2( 1.0f, 1.0f), glm::vec2(-1.0f, 1.0f),
+		};
+		glGenBuffers(1, &quad_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+		glBufferData(GL_ARRAY_BUFFER, corners.size() * sizeof(corners[0]), corners.data(), GL_STATIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		GL_ERRORS();
+	}
+
+	{ //vertex array mapping quad + instance buffers to program's attributes:
+		glGenVertexArrays(1, &vertex_buffer_for_rect_instance_program);
+		glBindVertexArray(vertex_buffer_for_rect_instance_program);
+
+		//corners come from the unit quad, one per vertex:
+		glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+		glVertexAttribPointer(program->Corner_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (GLbyte *)0 + 0);
+		glEnableVertexAttribArray(program->Corner_vec2);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		//center, radius, and color come from the stream or a retained buffer, one per instance
+		// (pointers are set in flush(), since each run of instances starts at a different buffer + offset):
+		glEnableVertexAttribArray(program->Center_vec2);
+		glVertexAttribDivisor(program->Center_vec2, 1);
+		glEnableVertexAttribArray(program->Radius_vec2);
+		glVertexAttribDivisor(program->Radius_vec2, 1);
+		glEnableVertexAttribArray(program->Color_vec4);
+		glVertexAttribDivisor(program->Color_vec4, 1);
+
+		glBindVertexArray(0);
+
+		GL_ERRORS();
+	}
+}
+
+DrawList::~DrawList() {
+	glDeleteVertexArrays(1, &vertex_buffer_for_rect_instance_program);
+	vertex_buffer_for_rect_instance_program = 0;
+
+	glDeleteBuffers(1, &quad_buffer);
+	quad_buffer = 0;
+}
+
+uint64_t DrawList::make_key(Layer layer, GLuint program_, GLuint texture, Blend blend) {
+	//(a frame only uses a handful of states, so a linear search is fine)
+	uint32_t index = 0;
+	while (index < states.size() && !(states[index].program == program_ && states[index].texture == texture && states[index].blend == blend)) {
+		++index;
+	}
+	if (index == states.size()) {
+		states.emplace_back(State{program_, texture, blend});
+	}
+	return (uint64_t(layer) << 32) | uint64_t(index);
+}
+
+void DrawList::push(Item item) {
+	item.order = uint32_t(items.size());
+	//anything else submitted to a layer ends its run of streamed rects:
+	open_run[item.layer] = (item.kind == KindStream ? uint32_t(items.size()) : -1U);
+	items.emplace_back(item);
+}
+
+void DrawList::rect(Layer layer, glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+	assert(layer < LayerCount);
+	std::vector< RectInstance > &rects = layer_rects[layer];
+	rects.emplace_back(center, radius, color);
+
+	if (open_run[layer] != -1U) {
+		//extend the layer's current run:
+		assert(items[open_run[layer]].end + 1 == rects.size());
+		items[open_run[layer]].end += 1;
+	} else {
+		Item item;
+		item.key = make_key(layer, program->program, 0, BlendAlpha);
+		item.kind = KindStream;
+		item.layer = layer;
+		item.buffer = 0;
+		item.begin = uint32_t(rects.size()) - 1;
+		item.end = uint32_t(rects.size());
+		item.vertices = 0;
+		push(item);
+	}
+}
+
+void DrawList::rects(Layer layer, GLuint buffer, uint32_t first, uint32_t count) {
+	assert(layer < LayerCount);
+	if (count == 0) return;
+	Item item;
+	item.key = make_key(layer, program->program, 0, BlendAlpha);
+	item.kind = KindRetained;
+	item.layer = layer;
+	item.buffer = buffer;
+	item.begin = first;
+	item.end = first + count;
+	item.vertices = 0;
+	push(item);
+}
+
+void DrawList::callback(Layer layer, GLuint program_, GLuint texture, Blend blend, uint32_t vertices,
+	std::function< void(glm::mat4 const &object_to_clip) > const &draw) {
+	assert(layer < LayerCount);
+	Item item;
+	item.key = make_key(layer, program_, texture, blend);
+	item.kind = KindCallback;
+	item.layer = layer;
+	item.buffer = 0;
+	item.begin = uint32_t(callbacks.size());
+	item.end = item.begin + 1;
+	item.vertices = vertices;
+	callbacks.emplace_back(draw);
+	push(item);
+}
+
+void DrawList::upload() {
+	if (uploaded) return;
+	uploaded = true;
+	stats = Stats();
+
+	//---- upload all streamed rects at once (layer by layer, so each layer's runs stay contiguous) ----
+	uint32_t streamed = 0;
+	for (uint32_t l = 0; l < LayerCount; ++l) {
+		layer_base[l] = streamed;
+		streamed += uint32_t(layer_rects[l].size());
+	}
+	stream_first = 0;
+	if (streamed > 0) {
+		uint8_t *data = reinterpret_cast< uint8_t * >(stream.map(streamed * sizeof(RectInstance)));
+		for (uint32_t l = 0; l < LayerCount; ++l) {
+			std::memcpy(data + layer_base[l] * sizeof(RectInstance), layer_rects[l].data(), layer_rects[l].size() * sizeof(RectInstance));
+		}
+		stream_first = uint32_t(stream.unmap(streamed * sizeof(RectInstance)) / sizeof(RectInstance));
+		stats.uploads += 1;
+		stats.upload_bytes += streamed * sizeof(RectInstance);
+	}
+}
+
+void DrawList::flush(glm::mat4 const &object_to_clip) {
+	upload();
+	stats.submissions = uint32_t(items.size());
+
+	std::sort(items.begin(), items.end(), [](Item const &a, Item const &b) {
+		if (a.key != b.key) return a.key < b.key;
+		return a.order < b.order;
+	});
+
+	//---- issue draws ----
+
+	//GL state as last set by this function (0 / -1U where unknown):
+	GLuint bound_program = -1U;
+	GLuint bound_texture = -1U;
+	uint32_t bound_blend = -1U;
+	bool bound_vao = false;
+
+	auto set_state = [&](uint32_t state) {
+		GLuint want_program = states[state].program;
+		GLuint want_texture = states[state].texture;
+		uint32_t want_blend = states[state].blend;
+		if (want_program != bound_program) {
+			glUseProgram(want_program);
+			bound_program = want_program;
+			if (want_program == program->program) {
+				glUniformMatrix4fv(program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+			}
+			stats.state_changes += 1;
+		}
+		if (want_texture != bound_texture) {
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_2D, want_texture);
+			bound_texture = want_texture;
+			stats.state_changes += 1;
+		}
+		if (want_blend != bound_blend) {
+			if (want_blend == BlendAlpha) {
+				glEnable(GL_BLEND);
+				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			} else {
+				glDisable(GL_BLEND);
+			}
+			bound_blend = want_blend;
+			stats.state_changes += 1;
+		}
+	};
+
+	//draw a run of RectInstances from 'buffer':
+	auto draw_rects = [&](uint32_t state, GLuint buffer, uint32_t first, uint32_t count) {
+		set_state(state);
+		if (!bound_vao) {
+			glBindVertexArray(vertex_buffer_for_rect_instance_program);
+			bound_vao = true;
+		}
+		GLintptr offset = GLintptr(first) * sizeof(RectInstance);
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glVertexAttribPointer(program->Center_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(RectInstance), (GLbyte *)0 + offset + 0);
+		glVertexAttribPointer(program->Radius_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(RectInstance), (GLbyte *)0 + offset + 4*2);
+		glVertexAttribPointer(program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(RectInstance), (GLbyte *)0 + offset + 4*2 + 4*2);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		glDrawArraysInstanced(GL_TRIANGLES, 0, 6, count);
+		stats.draw_calls += 1;
+		stats.vertices += 6 * count;
+	};
+
+	//the run of rects waiting to be drawn (merged with following items where possible):
+	bool pending = false;
+	uint32_t pending_state = 0;
+	GLuint pending_buffer = 0;
+	uint32_t pending_first = 0, pending_end = 0;
+
+	auto flush_pending = [&]() {
+		if (!pending) return;
+		draw_rects(pending_state, pending_buffer, pending_first, pending_end - pending_first);
+		pending = false;
+	};
+
+	for (Item const &item : items) {
+		uint32_t state = uint32_t(item.key & 0xffffffff);
+		if (item.kind == KindCallback) {
+			flush_pending();
+			set_state(state);
+			callbacks[item.begin](object_to_clip);
+			stats.draw_calls += 1;
+			stats.vertices += item.vertices;
+			//callback may have changed anything:
+			bound_program = -1U;
+			bound_texture = -1U;
+			bound_blend = -1U;
+			bound_vao = false;
+			continue;
+		}
+
+		GLuint buffer = (item.kind == KindStream ? stream.buffer : item.buffer);
+		uint32_t first = item.begin;
+		uint32_t end = item.end;
+		if (item.kind == KindStream) {
+			first += stream_first + layer_base[item.layer];
+			end += stream_first + layer_base[item.layer];
+		}
+
+		if (pending && pending_state == state && pending_buffer == buffer && pending_end == first) {
+			//continues the pending run:
+			pending_end = end;
+		} else {
+			flush_pending();
+			pending = true;
+			pending_state = state;
+			pending_buffer = buffer;
+			pending_first = first;
+			pending_end = end;
+		}
+	}
+	flush_pending();
+
+	if (bound_vao) glBindVertexArray(0);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glUseProgram(0);
+
+	stream.end_frame();
+
+	GL_ERRORS();
+
+	//---- reset for next frame ----
+	items.clear();
+	for (uint32_t l = 0; l < LayerCount; ++l) {
+		layer_rects[l].clear();
+		open_run[l] = -1U;
+	}
+	callbacks.clear();
+	states.clear();
+	uploaded = false;
+}
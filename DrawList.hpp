@@ -0,0 +1,123 @@
+#pragma once
+
+#include "RectInstanceProgram.hpp"
+#include "StreamBuffer.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+/*
+ * DrawList collects a frame's draws and issues them in as few GL calls as it can.
+ *
+ * Every submission has a key: (layer, state), where a state is a (program,
+ *  texture, blend) and states are numbered in the order they are first
+ *  submitted each frame. At flush() submissions are sorted by key -- so layers
+ *  always draw in order, and within a layer submissions with the same state
+ *  keep their submission order, while submissions with different state are
+ *  grouped by state, in the order the states were first used. (So draw order
+ *  depends only on submission order, never on GL object names.) Then:
+ *   - all streamed rectangles are uploaded with one map of the stream buffer,
+ *   - runs of rectangles that end up adjacent are merged into one instanced draw,
+ *   - program/texture/blend are only changed between runs that differ.
+ *
+ * Three kinds of submission:
+ *   rect()     -- one rectangle, streamed this frame (drawn with RectInstanceProgram);
+ *   rects()    -- 'count' RectInstances already in a (retained) GL buffer;
+ *   callback() -- arbitrary drawing with another program/texture; the callback
+ *                 is run with its program, texture (on GL_TEXTURE0), and
+ *                 blend state already set, and sets up anything else itself.
+ */
+
+struct DrawList {
+	enum Layer : uint8_t {
+		LayerShadow,
+		LayerTrail,
+		LayerSolid,
+		LayerOverlay,
+		LayerCount
+	};
+	enum Blend : uint8_t {
+		BlendAlpha, //src alpha, one minus src alpha
+		BlendNone,
+	};
+
+	//'program' is used for rect()/rects() submissions:
+	DrawList(std::shared_ptr< RectInstanceProgram const > const &program, StreamBuffer::Method method);
+	~DrawList();
+
+	DrawList(DrawList const &) = delete;
+	DrawList &operator=(DrawList const &) = delete;
+
+	void rect(Layer layer, glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color);
+	//'first' is an index (in RectInstances) into 'buffer':
+	void rects(Layer layer, GLuint buffer, uint32_t first, uint32_t count);
+	//'vertices' is only used for stats:
+	void callback(Layer layer, GLuint program, GLuint texture, Blend blend, uint32_t vertices,
+		std::function< void(glm::mat4 const &object_to_clip) > const &draw);
+
+	//copy this frame's streamed rects into the stream buffer
+	// (flush() does this itself if it hasn't been done; it's separate so it can be timed separately):
+	void upload();
+
+	//issue everything submitted since the last flush, then clear:
+	void flush(glm::mat4 const &object_to_clip);
+
+	//per-frame stats (of the most recent flush):
+	struct Stats {
+		uint32_t submissions = 0; //rect() calls count once per run of consecutive calls in a layer
+		uint32_t draw_calls = 0; //(callbacks count as one)
+		uint32_t state_changes = 0; //program, texture, or blend changes
+		uint32_t vertices = 0; //vertices drawn (6 per rectangle)
+		uint32_t uploads = 0; //buffer uploads (maps) for streamed rectangles
+		uint64_t upload_bytes = 0;
+	} stats;
+
+	//----- internals -----
+	std::shared_ptr< RectInstanceProgram const > program;
+
+	StreamBuffer stream; //streamed RectInstances
+	GLuint quad_buffer = 0; //six corners of the unit quad
+	GLuint vertex_buffer_for_rect_instance_program = 0;
+
+	enum Kind : uint8_t {
+		KindStream, //[begin,end) of layer_rects[layer]
+		KindRetained, //[begin,end) of 'buffer'
+		KindCallback, //callbacks[begin]
+	};
+	//this frame's distinct states, in order of first submission:
+	struct State {
+		GLuint program;
+		GLuint texture;
+		Blend blend;
+	};
+	std::vector< State > states;
+
+	struct Item {
+		uint64_t key; //layer, then index in 'states'
+		uint32_t order; //submission order
+		Kind kind;
+		Layer layer;
+		GLuint buffer;
+		uint32_t begin, end;
+		uint32_t vertices; //(callbacks only)
+	};
+	std::vector< Item > items;
+	std::vector< RectInstance > layer_rects[LayerCount];
+	std::vector< std::function< void(glm::mat4 const &) > > callbacks;
+	//index in 'items' of each layer's open run of streamed rects (or -1U):
+	uint32_t open_run[LayerCount];
+
+	//set by upload():
+	bool uploaded = false;
+	uint32_t layer_base[LayerCount]; //index of each layer's first rect among this frame's streamed rects
+	uint32_t stream_first = 0; //index (in RectInstances) of first streamed rect in stream.buffer
+
+	//(adds the state to 'states' if it is new this frame)
+	uint64_t make_key(Layer layer, GLuint program, GLuint texture, Blend blend);
+	void push(Item item);
+};
@@ -0,0 +1,186 @@
+#include "FrameCapture.hpp"
+
+#include "gl_errors.hpp"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FRAME_CAPTURE_SSE2 1
+#endif
+
+FrameCapture::FrameCapture(uint32_t buffers, uint32_t max_queued_) : readbacks(buffers), max_queued(max_queued_) {
+	assert(buffers >= 1);
+	for (Readback &readback : readbacks) {
+		glGenBuffers(1, &readback.buffer);
+	}
+	worker = std::thread(&FrameCapture::work, this);
+}
+
+FrameCapture::~FrameCapture() {
+	finish();
+
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	worker.join();
+
+	for (Readback &readback : readbacks) {
+		glDeleteBuffers(1, &readback.buffer);
+		readback.buffer = 0;
+	}
+}
+
+uint64_t FrameCapture::handled() const {
+	std::unique_lock< std::mutex > lock(mutex);
+	return handled_count;
+}
+
+bool FrameCapture::capture(glm::uvec2 const &size, GLenum read_buffer, Handler const &handler) {
+	Readback &readback = readbacks[next_readback];
+	size_t queued;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		queued = jobs.size() + working;
+	}
+	if (readback.fence || queued >= max_queued) {
+		dropped += 1;
+		return false;
+	}
+
+	size_t bytes = size_t(size.x) * size.y * 4;
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	if (readback.capacity < bytes) {
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+		readback.capacity = bytes;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	glReadBuffer(read_buffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	//(with a pixel-pack buffer bound, this just queues a copy into it; the last argument is an offset)
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, (GLbyte *)0 + 0);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.number = captured++;
+	readback.size = size;
+	readback.handler = handler;
+
+	next_readback = (next_readback + 1) % readbacks.size();
+	in_flight += 1;
+
+	GL_ERRORS();
+	return true;
+}
+
+bool FrameCapture::retire(Readback &readback, bool block) {
+	assert(readback.fence);
+	GLenum result = glClientWaitSync(readback.fence, 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		if (!block) return false;
+		do {
+			result = glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cerr << "WARNING: glClientWaitSync failed on frame readback; waiting with glFinish()." << std::endl;
+		glFinish();
+	}
+	glDeleteSync(readback.fence);
+	readback.fence = nullptr;
+	in_flight -= 1;
+
+	Job job;
+	job.frame.number = readback.number;
+	job.frame.size = readback.size;
+	job.frame.pixels.resize(size_t(readback.size.x) * readback.size.y);
+	job.handler = std::move(readback.handler);
+	readback.handler = nullptr;
+
+	size_t bytes = job.frame.pixels.size() * sizeof(glm::u8vec4);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	void *data = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, bytes, GL_MAP_READ_BIT);
+	if (data) {
+		std::memcpy(job.frame.pixels.data(), data, bytes);
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	} else {
+		std::cerr << "WARNING: failed to map frame readback buffer; frame " << job.frame.number << " skipped." << std::endl;
+		dropped += 1;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	GL_ERRORS();
+
+	if (data) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			jobs.emplace_back(std::move(job));
+		}
+		work_available.notify_one();
+	}
+	return true;
+}
+
+void FrameCapture::poll() {
+	//readbacks finish in the order they were started, so stop at the first unfinished one:
+	while (in_flight > 0) {
+		uint32_t oldest = uint32_t((next_readback + readbacks.size() - in_flight) % readbacks.size());
+		if (!retire(readbacks[oldest], false)) break;
+	}
+}
+
+void FrameCapture::finish() {
+	while (in_flight > 0) {
+		uint32_t oldest = uint32_t((next_readback + readbacks.size() - in_flight) % readbacks.size());
+		retire(readbacks[oldest], true);
+	}
+	std::unique_lock< std::mutex > lock(mutex);
+	work_done.wait(lock, [this](){ return jobs.empty() && working == 0; });
+}
+
+void FrameCapture::work() {
+	while (true) {
+		Job job;
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			work_available.wait(lock, [this](){ return stopping || !jobs.empty(); });
+			if (jobs.empty()) return; //stopping and out of work
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			working += 1;
+		}
+
+		try {
+			job.handler(job.frame);
+		} catch (std::exception const &e) {
+			std::cerr << "WARNING: frame capture handler failed on frame " << job.frame.number << ": " << e.what() << std::endl;
+		}
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			working -= 1;
+			handled_count += 1;
+		}
+		work_done.notify_all();
+	}
+}
+
+void FrameCapture::force_opaque(glm::u8vec4 *pixels, size_t count) {
+	static_assert(sizeof(glm::u8vec4) == 4, "pixels are packed RGBA bytes");
+	size_t i = 0;
+#ifdef FRAME_CAPTURE_SSE2
+	//four pixels at a time: OR in 0xff in every alpha byte (byte 3 of each little-endian 32-bit lane):
+	__m128i const alpha = _mm_set1_epi32(int32_t(0xff000000u));
+	for (; i + 4 <= count; i += 4) {
+		__m128i px = _mm_loadu_si128(reinterpret_cast< __m128i const * >(pixels + i));
+		_mm_storeu_si128(reinterpret_cast< __m128i * >(pixels + i), _mm_or_si128(px, alpha));
+	}
+#endif
+	for (; i < count; ++i) {
+		pixels[i].a = 0xff;
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+/*
+ * FrameCapture reads frames back from the GPU without stalling the render loop.
+ *
+ * capture() starts a glReadPixels into one of a ring of pixel-pack buffers and
+ *  drops a fence after it. poll() (once per frame) checks those fences without
+ *  waiting; once the GPU has finished a readback -- usually a frame or two
+ *  later -- its pixels are copied out of the mapped buffer and handed to a
+ *  background worker thread, which runs the capture's handler (e.g., saving a
+ *  PNG). So the main thread never waits on the GPU or on encoding.
+ *
+ * Back-pressure: if every pixel-pack buffer is still in flight, or the worker
+ *  already has max_queued frames waiting, capture() drops the frame (and
+ *  counts it) rather than block.
+ *
+ * Must be created and destroyed (and have capture/poll called) on the thread
+ *  that owns the GL context.
+ */
+
+struct FrameCapture {
+	struct Frame {
+		uint64_t number = 0; //sequence number of this capture
+		glm::uvec2 size = glm::uvec2(0);
+		std::vector< glm::u8vec4 > pixels; //RGBA, rows from the bottom up
+	};
+	//run on the worker thread, in capture order:
+	typedef std::function< void(Frame &frame) > Handler;
+
+	FrameCapture(uint32_t buffers = 3, uint32_t max_queued = 4);
+	~FrameCapture(); //finishes outstanding captures first
+
+	FrameCapture(FrameCapture const &) = delete;
+	FrameCapture &operator=(FrameCapture const &) = delete;
+
+	//start reading back 'size' pixels of the default framebuffer's 'read_buffer' (GL_BACK or GL_FRONT);
+	// returns false (and counts a drop) if there is no room:
+	bool capture(glm::uvec2 const &size, GLenum read_buffer, Handler const &handler);
+
+	//hand finished readbacks to the worker (never blocks):
+	void poll();
+
+	//wait for every capture so far to be read back and handled:
+	void finish();
+
+	//set alpha to 0xff for 'count' pixels (SSE2 where available):
+	static void force_opaque(glm::u8vec4 *pixels, size_t count);
+
+	//----- stats -----
+	uint64_t captured = 0; //capture() calls that started a readback
+	uint64_t dropped = 0; //capture() calls turned away (no free buffer / worker too far behind)
+	uint64_t handled() const; //frames the worker has finished with
+
+	//----- internals -----
+	struct Readback {
+		GLuint buffer = 0; //GL_PIXEL_PACK_BUFFER
+		size_t capacity = 0; //bytes allocated for 'buffer'
+		GLsync fence = nullptr; //non-null while in flight
+		uint64_t number = 0;
+		glm::uvec2 size = glm::uvec2(0);
+		Handler handler;
+	};
+	std::vector< Readback > readbacks;
+	uint32_t next_readback = 0; //readbacks are started (and finished) in ring order
+	uint32_t in_flight = 0;
+
+	//move a finished readback's pixels to the worker; if 'block', wait for the GPU instead of giving up:
+	bool retire(Readback &readback, bool block);
+
+	struct Job {
+		Frame frame;
+		Handler handler;
+	};
+	uint32_t max_queued;
+	mutable std::mutex mutex;
+	std::condition_variable work_available;
+	std::condition_variable work_done;
+	std::deque< Job > jobs; //guarded by mutex
+	uint32_t working = 0; //jobs taken but not finished (guarded by mutex)
+	uint64_t handled_count = 0; //(guarded by mutex)
+	bool stopping = false; //(guarded by mutex)
+	std::thread worker;
+	void work();
+};
@@ -0,0 +1,32 @@
+#include "GLResources.hpp"
+
+#include <cstdio>
+
+uint64_t GLResources::hits = 0;
+uint64_t GLResources::misses = 0;
+
+std::unordered_map< std::string, std::weak_ptr< void > > &GLResources::registry() {
+	//(function-local so it is constructed before any static user needs it)
+	static std::unordered_map< std::string, std::weak_ptr< void > > map;
+	return map;
+}
+
+std::string GLResources::hash(std::string const &data) {
+	uint64_t h = 0xcbf29ce484222325ull;
+	for (char c : data) {
+		h ^= uint8_t(c);
+		h *= 0x100000001b3ull;
+	}
+	char hex[17];
+	std::snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)h);
+	return hex;
+}
+
+size_t GLResources::prune() {
+	auto &map = registry();
+	for (auto i = map.begin(); i != map.end(); ) {
+		if (i->second.expired()) i = map.erase(i);
+		else ++i;
+	}
+	return map.size();
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <typeinfo>
+#include <type_traits>
+#include <unordered_map>
+#include <cstdint>
+
+/*
+ * GLResources is a process-wide registry of shared GL objects (programs,
+ *  buffers, textures, vertex arrays, and objects built from them).
+ *
+ * get< T >(key, make) returns the live T registered under 'key' if there is
+ *  one, and otherwise calls make() and registers the result. The registry
+ *  only holds weak references: an object is freed when its last user lets go
+ *  of it. A new Mode that asks for the same resources while the old Mode is
+ *  still alive (as with Mode::set_current(std::make_shared< ... >())) just
+ *  picks up the old Mode's objects -- no shader compiles, no re-uploads.
+ *
+ * Keys are descriptions ("RectInstanceProgram", "court 10x5") or, for
+ *  content-defined objects, hashes of that content (see hash()).
+ *
+ * Like the rest of GL, this is only for use from the thread that owns the context.
+ */
+
+struct GLResources {
+	template< typename T >
+	static std::shared_ptr< T > get(std::string const &key, std::function< std::shared_ptr< T >() > const &make) {
+		//(type is part of the key, so different kinds of resource can't collide)
+		std::string full_key = std::string(typeid(T).name()) + ":" + key;
+		auto found = registry().find(full_key);
+		if (found != registry().end()) {
+			if (std::shared_ptr< void > live = found->second.lock()) {
+				hits += 1;
+				return std::static_pointer_cast< T >(live);
+			}
+		}
+		misses += 1;
+		//(misses are rare -- mode changes, new content -- so this is where dead entries get cleared out)
+		prune();
+		std::shared_ptr< T > made = make();
+		//(looked up again: make() may itself get() -- and prune -- other resources)
+		//(const is cast away only to store a type-erased pointer; objects come back out as T)
+		registry()[full_key] = std::const_pointer_cast< typename std::remove_const< T >::type >(made);
+		return made;
+	}
+
+	//FNV-1a hash, as a hex string (for keying resources by source text or data):
+	static std::string hash(std::string const &data);
+
+	//drop registry entries whose objects have been freed; returns the number still live:
+	// (get() does this on every miss)
+	static size_t prune();
+
+	//get() calls that found a live object / had to make one:
+	static uint64_t hits;
+	static uint64_t misses;
+
+	static std::unordered_map< std::string, std::weak_ptr< void > > &registry();
+};
+
+//RAII wrappers for plain GL object names, for sharing through GLResources:
+
+struct GLBuffer {
+	GLBuffer() { glGenBuffers(1, &name); }
+	~GLBuffer() { glDeleteBuffers(1, &name); }
+	GLBuffer(GLBuffer const &) = delete;
+	GLBuffer &operator=(GLBuffer const &) = delete;
+	GLuint name = 0;
+};
+
+struct GLTexture {
+	GLTexture() { glGenTextures(1, &name); }
+	~GLTexture() { glDeleteTextures(1, &name); }
+	GLTexture(GLTexture const &) = delete;
+	GLTexture &operator=(GLTexture const &) = delete;
+	GLuint name = 0;
+};
+
+struct GLVertexArray {
+	GLVertexArray() { glGenVertexArrays(1, &name); }
+	~GLVertexArray() { glDeleteVertexArrays(1, &name); }
+	GLVertexArray(GLVertexArray const &) = delete;
+	GLVertexArray &operator=(GLVertexArray const &) = delete;
+	GLuint name = 0;
+};
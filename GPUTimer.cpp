@@ -0,0 +1,148 @@
+#include "GPUTimer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+
+GPUTimer::GPUTimer(uint32_t frames_in_flight, uint32_t window_) : window(window_), frames(frames_in_flight) {
+	assert(frames_in_flight >= 1);
+	assert(window >= 1);
+	scope_index("frame");
+}
+
+GPUTimer::~GPUTimer() {
+	for (Frame &frame : frames) {
+		if (!frame.queries.empty()) glDeleteQueries(GLsizei(frame.queries.size()), frame.queries.data());
+		frame.queries.clear();
+	}
+}
+
+void GPUTimer::log_csv(std::string const &path) {
+	csv.open(path);
+	if (!csv) {
+		std::cerr << "WARNING: couldn't open '" << path << "' for GPU timings." << std::endl;
+		return;
+	}
+	csv << "frame,scope,gpu_ms\n";
+}
+
+uint32_t GPUTimer::scope_index(std::string const &name) {
+	for (uint32_t i = 0; i < scopes.size(); ++i) {
+		if (scopes[i].name == name) return i;
+	}
+	scopes.emplace_back();
+	scopes.back().name = name;
+	return uint32_t(scopes.size()) - 1;
+}
+
+GLuint GPUTimer::next_query() {
+	Frame &frame = frames[current];
+	if (frame.used == frame.queries.size()) {
+		GLuint query = 0;
+		glGenQueries(1, &query);
+		frame.queries.emplace_back(query);
+	}
+	return frame.used++;
+}
+
+void GPUTimer::begin_frame() {
+	assert(open.empty());
+	current = (current + 1) % frames.size();
+	Frame &frame = frames[current];
+
+	//this slot was last used frames.size() frames ago; collect its results (if ready) before reuse:
+	if (frame.pending) read(frame);
+
+	frame.used = 0;
+	frame.records.clear();
+	frame.frame_number = frame_number++;
+	frame.pending = false;
+
+	begin("frame");
+}
+
+void GPUTimer::begin(std::string const &name) {
+	Frame &frame = frames[current];
+	Record record;
+	record.scope = scope_index(name);
+	record.begin_query = next_query();
+	record.end_query = -1U;
+	glQueryCounter(frame.queries[record.begin_query], GL_TIMESTAMP);
+	open.emplace_back(uint32_t(frame.records.size()));
+	frame.records.emplace_back(record);
+}
+
+void GPUTimer::end() {
+	assert(!open.empty());
+	Frame &frame = frames[current];
+	Record &record = frame.records[open.back()];
+	open.pop_back();
+	record.end_query = next_query();
+	glQueryCounter(frame.queries[record.end_query], GL_TIMESTAMP);
+}
+
+void GPUTimer::end_frame() {
+	assert(open.size() == 1 && "every begin() should have an end() before end_frame()");
+	end(); //"frame"
+	frames[current].pending = true;
+	GL_ERRORS();
+}
+
+void GPUTimer::read(Frame &frame) {
+	frame.pending = false;
+
+	//the "frame" scope's end timestamp was issued last, so once it is available the rest are too:
+	GLint available = GL_FALSE;
+	glGetQueryObjectiv(frame.queries[frame.records[0].end_query], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available != GL_TRUE) {
+		frames_dropped += 1;
+		return;
+	}
+
+	std::vector< double > ms(scopes.size(), 0.0);
+	std::vector< bool > seen(scopes.size(), false);
+	for (Record const &record : frame.records) {
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(frame.queries[record.begin_query], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[record.end_query], GL_QUERY_RESULT, &end);
+		ms[record.scope] += (end > begin ? double(end - begin) : 0.0) / 1.0e6;
+		seen[record.scope] = true;
+	}
+
+	for (uint32_t s = 0; s < scopes.size(); ++s) {
+		if (!seen[s]) continue;
+		Scope &scope = scopes[s];
+		if (scope.samples.size() < window) {
+			scope.samples.emplace_back(ms[s]);
+		} else {
+			scope.sum -= scope.samples[scope.next];
+			scope.samples[scope.next] = ms[s];
+		}
+		scope.next = (scope.next + 1) % window;
+		scope.sum += ms[s];
+		scope.last = ms[s];
+
+		if (csv.is_open()) {
+			char buffer[32];
+			std::snprintf(buffer, sizeof(buffer), "%.4f", ms[s]);
+			csv << frame.frame_number << ',' << scope.name << ',' << buffer << '\n';
+		}
+	}
+	frames_read += 1;
+}
+
+std::string GPUTimer::summary() const {
+	std::string ret;
+	for (Scope const &scope : scopes) {
+		if (scope.samples.empty()) continue;
+		char buffer[64];
+		std::snprintf(buffer, sizeof(buffer), "%s%s %.3fms", (ret.empty() ? "" : ", "), scope.name.c_str(), scope.average());
+		ret += buffer;
+	}
+	if (frames_dropped) {
+		ret += " (" + std::to_string(frames_dropped) + " frames not ready in time)";
+	}
+	return ret;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * GPUTimer measures how long the GPU spends on named scopes of a frame.
+ *
+ * Each begin()/end() drops a GL_TIMESTAMP query (glQueryCounter), so scopes
+ *  may nest. Queries are recorded into a ring of 'frames_in_flight' frames
+ *  and read back when their slot comes around again -- by then the GPU has
+ *  almost always finished them, and if it hasn't, that frame's results are
+ *  dropped rather than waited for. So timing never stalls the pipeline, and
+ *  results lag the current frame by frames_in_flight frames.
+ *
+ * Usage, per frame:
+ *   timer.begin_frame(); //(also starts the implicit "frame" scope)
+ *   timer.begin("draw"); ... GL calls ... timer.end();
+ *   timer.end_frame();
+ *
+ * Scopes that appear more than once in a frame are summed.
+ */
+
+struct GPUTimer {
+	//'window' is the number of frames in each rolling average:
+	GPUTimer(uint32_t frames_in_flight = 4, uint32_t window = 60);
+	~GPUTimer();
+
+	GPUTimer(GPUTimer const &) = delete;
+	GPUTimer &operator=(GPUTimer const &) = delete;
+
+	void begin_frame();
+	void begin(std::string const &name);
+	void end();
+	void end_frame();
+
+	//also write every measurement to 'path' as CSV rows of frame,scope,gpu_ms:
+	void log_csv(std::string const &path);
+
+	struct Scope {
+		std::string name;
+		std::vector< double > samples; //last 'window' per-frame times (ms), as a ring
+		uint32_t next = 0; //next slot to write in samples
+		double sum = 0.0; //sum of samples
+		double last = 0.0; //most recently read time (ms)
+		double average() const { return samples.empty() ? 0.0 : sum / samples.size(); }
+	};
+	std::vector< Scope > scopes; //scopes[0] is "frame"
+
+	//"frame 1.23ms, clear 0.01ms, ..." (rolling averages):
+	std::string summary() const;
+
+	uint64_t frames_read = 0; //frames whose results were read back
+	uint64_t frames_dropped = 0; //frames whose results weren't ready in time
+
+	//----- internals -----
+	uint32_t window;
+	uint64_t frame_number = 0;
+
+	struct Record {
+		uint32_t scope;
+		uint32_t begin_query, end_query; //indices into Frame::queries
+	};
+	struct Frame {
+		std::vector< GLuint > queries; //pool of query objects (grows as needed)
+		uint32_t used = 0; //queries used this frame
+		std::vector< Record > records;
+		uint64_t frame_number = 0;
+		bool pending = false; //has queries waiting to be read
+	};
+	std::vector< Frame > frames;
+	uint32_t current = 0; //index in 'frames' being recorded
+	std::vector< uint32_t > open; //indices in frames[current].records of scopes begun but not ended
+
+	std::ofstream csv;
+
+	uint32_t scope_index(std::string const &name);
+	GLuint next_query();
+	void read(Frame &frame);
+};
@@ -0,0 +1,206 @@
+#include "HudText.hpp"
+
+#include "gl_errors.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//built-in 5x7 bitmap font; each row is five bits, leftmost pixel in the high bit, top row first:
+struct Glyph {
+	char c;
+	uint8_t rows[7];
+};
+static const Glyph font[] = {
+	{'0', {0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e}},
+	{'1', {0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e}},
+	{'2', {0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f}},
+	{'3', {0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e}},
+	{'4', {0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02}},
+	{'5', {0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e}},
+	{'6', {0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e}},
+	{'7', {0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}},
+	{'8', {0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e}},
+	{'9', {0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c}},
+	{'$', {0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04}},
+	{'-', {0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00}},
+};
+static constexpr uint32_t GLYPH_COUNT = sizeof(font) / sizeof(font[0]);
+static constexpr uint32_t GLYPH_W = 5, GLYPH_H = 7;
+//each glyph sits in a cell with a one-pixel transparent border (so neighbors never bleed in):
+static constexpr uint32_t CELL_W = GLYPH_W + 2, CELL_H = GLYPH_H + 2;
+
+//index of glyph for 'c' in the atlas, or -1U if there isn't one:
+static uint32_t glyph_index(char c) {
+	for (uint32_t i = 0; i < GLYPH_COUNT; ++i) {
+		if (font[i].c == c) return i;
+	}
+	return -1U;
+}
+
+HudText::HudText(std::shared_ptr< ColorTextureProgram const > const &program_, uint32_t label_count) : labels(label_count), program(program_) {
+	{ //rasterize the font into the atlas:
+		glm::uvec2 size = glm::uvec2(CELL_W * GLYPH_COUNT, CELL_H);
+		std::vector< glm::u8vec4 > data(size.x * size.y, glm::u8vec4(0xff, 0xff, 0xff, 0x00));
+		for (uint32_t g = 0; g < GLYPH_COUNT; ++g) {
+			for (uint32_t row = 0; row < GLYPH_H; ++row) {
+				//(texture rows go bottom-to-top)
+				uint32_t y = 1 + (GLYPH_H - 1 - row);
+				for (uint32_t col = 0; col < GLYPH_W; ++col) {
+					if (font[g].rows[row] & (1 << (GLYPH_W - 1 - col))) {
+						uint32_t x = g * CELL_W + 1 + col;
+						data[y * size.x + x].a = 0xff;
+					}
+				}
+			}
+		}
+
+		glGenTextures(1, &atlas_tex);
+		glBindTexture(GL_TEXTURE_2D, atlas_tex);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+		//crisp pixels:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		GL_ERRORS();
+	}
+
+	{ //vertex buffer (every glyph starts out degenerate):
+		vertices.assign(labels.size() * MAX_CHARS * 6, Vertex(glm::vec3(0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::vec2(0.0f)));
+
+		glGenBuffers(1, &vertex_buffer);
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+		GL_ERRORS();
+	}
+
+	{ //vertex array mapping vertex_buffer to program's attributes:
+		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
+		glBindVertexArray(vertex_buffer_for_color_texture_program);
+		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+
+		glVertexAttribPointer(program->Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0 + 0);
+		glEnableVertexAttribArray(program->Position_vec4);
+		glVertexAttribPointer(program->Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLbyte *)0 + 4*3);
+		glEnableVertexAttribArray(program->Color_vec4);
+		glVertexAttribPointer(program->TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0 + 4*3 + 4*1);
+		glEnableVertexAttribArray(program->TexCoord_vec2);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindVertexArray(0);
+
+		GL_ERRORS();
+	}
+}
+
+HudText::~HudText() {
+	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
+	vertex_buffer_for_color_texture_program = 0;
+
+	glDeleteBuffers(1, &vertex_buffer);
+	vertex_buffer = 0;
+
+	glDeleteTextures(1, &atlas_tex);
+	atlas_tex = 0;
+}
+
+void HudText::set(uint32_t index, std::string const &text_, glm::vec2 const &anchor, float height, glm::u8vec4 const &color, Align align) {
+	assert(index < labels.size());
+	std::string text = text_.substr(0, MAX_CHARS);
+
+	Label &label = labels[index];
+	if (label.text == text && label.anchor == anchor && label.height == height && label.color == color && label.align == align
+	 && label.grid_origin == grid_origin && label.grid_pixel == grid_pixel) {
+		return; //nothing to do
+	}
+	label.text = text;
+	label.anchor = anchor;
+	label.height = height;
+	label.color = color;
+	label.align = align;
+	label.grid_origin = grid_origin;
+	label.grid_pixel = grid_pixel;
+	label.dirty = true;
+
+	//lay out glyph quads:
+	float pixel = height / GLYPH_H; //size of a font texel
+	if (grid_pixel > 0.0f) {
+		pixel = std::max(1.0f, std::round(pixel / grid_pixel)) * grid_pixel;
+	}
+	float advance = (GLYPH_W + 1) * pixel;
+	float width = text.size() * advance - pixel; //(no spacing after last glyph)
+	glm::vec2 at = glm::vec2(
+		(align == AlignLeft ? anchor.x : anchor.x - width),
+		anchor.y - 0.5f * GLYPH_H * pixel
+	);
+	if (grid_pixel > 0.0f) {
+		at = grid_origin + glm::round((at - grid_origin) / grid_pixel) * grid_pixel;
+	}
+
+	glm::vec2 atlas_size = glm::vec2(CELL_W * GLYPH_COUNT, CELL_H);
+
+	Vertex *out = &vertices[index * MAX_CHARS * 6];
+	for (uint32_t i = 0; i < MAX_CHARS; ++i, at.x += advance) {
+		uint32_t g = (i < text.size() ? glyph_index(text[i]) : -1U);
+		if (g == -1U) {
+			//blank: degenerate quad
+			for (uint32_t v = 0; v < 6; ++v) {
+				*(out++) = Vertex(glm::vec3(0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0x00), glm::vec2(0.0f));
+			}
+			continue;
+		}
+		glm::vec2 min = at;
+		glm::vec2 max = at + glm::vec2(GLYPH_W, GLYPH_H) * pixel;
+		glm::vec2 tex_min = glm::vec2(g * CELL_W + 1, 1) / atlas_size;
+		glm::vec2 tex_max = glm::vec2(g * CELL_W + 1 + GLYPH_W, 1 + GLYPH_H) / atlas_size;
+
+		//two CCW-oriented triangles:
+		*(out++) = Vertex(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(tex_min.x, tex_min.y));
+		*(out++) = Vertex(glm::vec3(max.x, min.y, 0.0f), color, glm::vec2(tex_max.x, tex_min.y));
+		*(out++) = Vertex(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(tex_max.x, tex_max.y));
+
+		*(out++) = Vertex(glm::vec3(min.x, min.y, 0.0f), color, glm::vec2(tex_min.x, tex_min.y));
+		*(out++) = Vertex(glm::vec3(max.x, max.y, 0.0f), color, glm::vec2(tex_max.x, tex_max.y));
+		*(out++) = Vertex(glm::vec3(min.x, max.y, 0.0f), color, glm::vec2(tex_min.x, tex_max.y));
+	}
+}
+
+void HudText::set_pixel_grid(glm::vec2 const &origin, float pixel_size) {
+	grid_origin = origin;
+	grid_pixel = pixel_size;
+}
+
+void HudText::draw(glm::mat4 const &object_to_clip) {
+	//upload changed labels:
+	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+	for (uint32_t i = 0; i < labels.size(); ++i) {
+		if (!labels[i].dirty) continue;
+		size_t first = i * MAX_CHARS * 6;
+		glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(Vertex), MAX_CHARS * 6 * sizeof(Vertex), &vertices[first]);
+		labels[i].dirty = false;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glUseProgram(program->program);
+	glUniformMatrix4fv(program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+
+	glBindVertexArray(vertex_buffer_for_color_texture_program);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, atlas_tex);
+
+	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glBindVertexArray(0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
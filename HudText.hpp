@@ -0,0 +1,83 @@
+#pragma once
+
+#include "ColorTextureProgram.hpp"
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * HudText draws a fixed number of short text labels (money, health, ...)
+ *  with glyphs from a small built-in bitmap font, packed into one atlas texture.
+ *
+ * Each label owns MAX_CHARS glyph quads in a static vertex buffer; set() only
+ *  re-lays-out (and re-uploads) a label whose text, position, size, or color
+ *  actually changed, so the per-frame cost and vertex count stay constant no
+ *  matter how large the numbers get.
+ */
+
+struct HudText {
+	enum Align {
+		AlignLeft, //anchor is at left edge of text
+		AlignRight, //anchor is at right edge of text
+	};
+
+	//longest label text (longer text is truncated); enough for "$" and any uint32_t:
+	static constexpr uint32_t MAX_CHARS = 11;
+
+	//'program' is used to draw glyphs:
+	HudText(std::shared_ptr< ColorTextureProgram const > const &program, uint32_t labels);
+	~HudText();
+
+	HudText(HudText const &) = delete;
+	HudText &operator=(HudText const &) = delete;
+
+	//set the text of a label; 'anchor' is at the vertical center of the text, 'height' is the height of a glyph:
+	// (supported characters are "0123456789$-" and space; others draw as space)
+	void set(uint32_t label, std::string const &text, glm::vec2 const &anchor, float height, glm::u8vec4 const &color, Align align);
+
+	//set the drawable pixel grid (in the same units as set()'s anchor): 'origin' is a pixel corner, 'pixel_size' is one pixel's size.
+	// set() rounds glyph heights to whole pixels per font texel (at least one) and snaps glyphs to pixel corners,
+	// so nearest-filtered glyphs neither drop nor double rows. (pixel_size 0 -- the default -- means no snapping)
+	void set_pixel_grid(glm::vec2 const &origin, float pixel_size);
+
+	//upload any changed labels and draw all of them:
+	void draw(glm::mat4 const &object_to_clip);
+
+	//----- internals -----
+	struct Vertex {
+		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+		glm::vec3 Position;
+		glm::u8vec4 Color;
+		glm::vec2 TexCoord;
+	};
+	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "HudText::Vertex should be packed");
+
+	struct Label {
+		std::string text;
+		glm::vec2 anchor = glm::vec2(0.0f);
+		float height = 0.0f;
+		glm::u8vec4 color = glm::u8vec4(0x00, 0x00, 0x00, 0x00);
+		Align align = AlignLeft;
+		glm::vec2 grid_origin = glm::vec2(0.0f); //pixel grid the label was laid out on
+		float grid_pixel = 0.0f;
+		bool dirty = false; //vertices changed since last upload
+	};
+	std::vector< Label > labels;
+
+	glm::vec2 grid_origin = glm::vec2(0.0f);
+	float grid_pixel = 0.0f;
+
+	std::shared_ptr< ColorTextureProgram const > program;
+
+	GLuint atlas_tex = 0; //glyphs in a single row (white, with coverage in alpha)
+	GLuint vertex_buffer = 0; //MAX_CHARS * 6 vertices per label
+	GLuint vertex_buffer_for_color_texture_program = 0;
+
+	std::vector< Vertex > vertices; //CPU copy of vertex_buffer
+};
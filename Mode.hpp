@@ -15,8 +15,14 @@ struct Mode : std::enable_shared_from_this< Mode > {
 
 	//update is called at the start of a new frame, after events are handled:
 	// 'elapsed' is time in seconds since the last call to 'update'
+	// (with a fixed tick rate -- see main.cpp -- this may be called several times per frame, always with the same 'elapsed')
 	virtual void update(float elapsed) { }
 
+	//set_tick_fraction is called after update, before draw:
+	// with a fixed tick rate, 'fraction' (in [0,1]) is how far the display is from the last update toward the next one,
+	// so moving things can be drawn interpolated between the last two updates (with a variable timestep it is always 1)
+	virtual void set_tick_fraction(float fraction) { }
+
 	//draw is called after update:
 	virtual void draw(glm::uvec2 const &drawable_size) = 0;
 
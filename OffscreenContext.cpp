@@ -0,0 +1,183 @@
+#include "OffscreenContext.hpp"
+
+#include "gl_errors.hpp"
+
+//(keep X11's macros out -- nothing here needs a window system)
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+//is 'name' in a space-separated extension string?
+static bool has_extension(char const *extensions, char const *name) {
+	if (!extensions) return false;
+	size_t length = std::strlen(name);
+	for (char const *at = extensions; (at = std::strstr(at, name)); at += length) {
+		bool starts = (at == extensions || at[-1] == ' ');
+		bool ends = (at[length] == ' ' || at[length] == '\0');
+		if (starts && ends) return true;
+	}
+	return false;
+}
+
+static std::string egl_error(char const *what) {
+	char hex[16];
+	std::snprintf(hex, sizeof(hex), "0x%04x", unsigned(eglGetError()));
+	return std::string(what) + " failed (EGL error " + hex + ")";
+}
+
+OffscreenContext::OffscreenContext(glm::uvec2 const &size_, bool debug) : size(size_) {
+	if (size.x == 0 || size.y == 0) {
+		throw std::runtime_error("OffscreenContext size must be non-zero.");
+	}
+
+	//----- display -----
+	//(client extensions are queried with EGL_NO_DISPLAY; older EGLs return NULL for that)
+	char const *client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	EGLDisplay dpy = EGL_NO_DISPLAY;
+	if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless") && has_extension(client_extensions, "EGL_EXT_platform_base")) {
+		auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (get_platform_display) {
+			dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+			if (dpy != EGL_NO_DISPLAY) description = "surfaceless platform";
+		}
+	}
+	if (dpy == EGL_NO_DISPLAY) {
+		dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+		description = "default display";
+	}
+	if (dpy == EGL_NO_DISPLAY) {
+		throw std::runtime_error("No EGL display available.");
+	}
+
+	EGLint major = 0, minor = 0;
+	if (!eglInitialize(dpy, &major, &minor)) {
+		throw std::runtime_error(egl_error("eglInitialize"));
+	}
+	display = dpy;
+	description = "EGL " + std::to_string(major) + "." + std::to_string(minor) + " " + description;
+
+	try {
+		bool surfaceless = has_extension(eglQueryString(dpy, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+		//----- context -----
+		if (!eglBindAPI(EGL_OPENGL_API)) {
+			throw std::runtime_error(egl_error("eglBindAPI(EGL_OPENGL_API)"));
+		}
+
+		EGLint const config_attribs[] = {
+			EGL_SURFACE_TYPE, (surfaceless ? 0 : EGL_PBUFFER_BIT),
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_ALPHA_SIZE, 8,
+			EGL_NONE
+		};
+		EGLConfig config = nullptr;
+		EGLint configs = 0;
+		if (!eglChooseConfig(dpy, config_attribs, &config, 1, &configs) || configs == 0) {
+			throw std::runtime_error(egl_error("eglChooseConfig (desktop GL, RGBA8)"));
+		}
+
+		//(EGL_CONTEXT_FLAGS_KHR works with both EGL 1.5 and EGL_KHR_create_context)
+		EGLint const context_attribs[] = {
+			EGL_CONTEXT_MAJOR_VERSION, 3,
+			EGL_CONTEXT_MINOR_VERSION, 3,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_CONTEXT_FLAGS_KHR, (debug ? EGL_CONTEXT_OPENGL_DEBUG_BIT_KHR : 0),
+			EGL_NONE
+		};
+		context = eglCreateContext(dpy, config, EGL_NO_CONTEXT, context_attribs);
+		if (context == EGL_NO_CONTEXT) {
+			context = nullptr;
+			throw std::runtime_error(egl_error("eglCreateContext (OpenGL 3.3 core)"));
+		}
+
+		if (surfaceless) {
+			description += ", surfaceless context";
+		} else {
+			EGLint const pbuffer_attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+			surface = eglCreatePbufferSurface(dpy, config, pbuffer_attribs);
+			if (surface == EGL_NO_SURFACE) {
+				surface = nullptr;
+				throw std::runtime_error(egl_error("eglCreatePbufferSurface"));
+			}
+			description += ", pbuffer";
+		}
+		if (debug) description += ", debug";
+		EGLSurface draw = (surface ? EGLSurface(surface) : EGL_NO_SURFACE);
+		if (!eglMakeCurrent(dpy, draw, draw, EGLContext(context))) {
+			throw std::runtime_error(egl_error("eglMakeCurrent"));
+		}
+	} catch (...) {
+		release();
+		throw;
+	}
+
+	//(on Linux this has nothing to load -- GL entry points are linked directly -- but it is the documented step after making a context)
+	init_GL();
+
+	description += ": " + std::string((char const *)glGetString(GL_RENDERER));
+
+	//----- framebuffer -----
+	glGenRenderbuffers(1, &color_renderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, color_renderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, size.x, size.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color_renderbuffer);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE) {
+		char hex[16];
+		std::snprintf(hex, sizeof(hex), "0x%04x", unsigned(status));
+		release();
+		throw std::runtime_error(std::string("Offscreen framebuffer is incomplete (status ") + hex + ").");
+	}
+	//(left bound, so drawing goes here)
+	glViewport(0, 0, size.x, size.y);
+
+	GL_ERRORS();
+}
+
+OffscreenContext::~OffscreenContext() {
+	release();
+}
+
+void OffscreenContext::release() {
+	//(GL objects only exist once the context has been made current)
+	if (framebuffer || color_renderbuffer) {
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &framebuffer);
+		framebuffer = 0;
+		glDeleteRenderbuffers(1, &color_renderbuffer);
+		color_renderbuffer = 0;
+	}
+
+	if (!display) return;
+	EGLDisplay dpy = EGLDisplay(display);
+	eglMakeCurrent(dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (surface) eglDestroySurface(dpy, EGLSurface(surface));
+	if (context) eglDestroyContext(dpy, EGLContext(context));
+	eglTerminate(dpy);
+	surface = context = display = nullptr;
+}
+
+void *OffscreenContext::get_proc_address(char const *name) {
+	return reinterpret_cast< void * >(eglGetProcAddress(name));
+}
+
+void OffscreenContext::read_pixels(std::vector< glm::u8vec4 > *pixels) const {
+	pixels->resize(size_t(size.x) * size.y);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glReadBuffer(GL_COLOR_ATTACHMENT0);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, size.x, size.y, GL_RGBA, GL_UNSIGNED_BYTE, pixels->data());
+	GL_ERRORS();
+}
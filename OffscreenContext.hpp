@@ -0,0 +1,63 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * OffscreenContext is an OpenGL 3.3 core context with no window, for rendering
+ *  on machines without a display (CI, perf boxes).
+ *
+ * It is made with EGL: on Mesa's surfaceless platform if the EGL library
+ *  offers it (EGL_MESA_platform_surfaceless), otherwise on the default display;
+ *  the context is made current without a surface if EGL_KHR_surfaceless_context
+ *  is supported, and with a 1x1 pbuffer if not. Either way, drawing goes to a
+ *  size.x by size.y RGBA8 framebuffer object, which is left bound (with the
+ *  viewport set to cover it) -- so code that draws to "the current framebuffer"
+ *  (like Mode::draw) works unchanged.
+ *
+ * To use Mesa's software rasterizer (no GPU at all), run with
+ *  LIBGL_ALWAYS_SOFTWARE=1 (and, if there is no DRM device, EGL_PLATFORM=surfaceless).
+ *
+ * If 'debug' is set, asks for a debug context (as --gl-debug full does); GL
+ *  entry points outside of GL.hpp (e.g., for gl_debug_init) must be looked up
+ *  with get_proc_address, since SDL_GL_GetProcAddress knows nothing of EGL.
+ *
+ * Only available on Linux (it is the only platform the Jamfile builds it for).
+ * Throws std::runtime_error if no context can be made.
+ */
+
+struct OffscreenContext {
+	OffscreenContext(glm::uvec2 const &size, bool debug = false);
+	~OffscreenContext();
+
+	OffscreenContext(OffscreenContext const &) = delete;
+	OffscreenContext &operator=(OffscreenContext const &) = delete;
+
+	glm::uvec2 size;
+
+	//read the framebuffer's pixels (RGBA, rows from the bottom up, as load_save_png's LowerLeftOrigin):
+	// (waits for all drawing to finish)
+	void read_pixels(std::vector< glm::u8vec4 > *pixels) const;
+
+	//eglGetProcAddress (as a GLGetProcAddress; see gl_errors.hpp):
+	static void *get_proc_address(char const *name);
+
+	//how the context was made and what is rendering it (e.g., "EGL 1.5 surfaceless, llvmpipe (LLVM 15.0.7, 256 bits)"):
+	std::string description;
+
+	//EGL handles (as void * to keep EGL's headers out of this one):
+	void *display = nullptr;
+	void *context = nullptr;
+	void *surface = nullptr; //(pbuffer, if the context couldn't be made current without one)
+
+	GLuint framebuffer = 0;
+	GLuint color_renderbuffer = 0;
+
+	//free whatever has been made so far (used by the destructor, and by the constructor before it throws):
+	void release();
+};
@@ -0,0 +1,85 @@
+#include "PlacementMap.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+PlacementMap::PlacementMap(glm::vec2 const &min_, glm::vec2 const &max_, glm::vec2 const &building_radius) : min(min_) {
+	//a building at one slot must not touch a building at the next slot (touching counts as overlap):
+	glm::vec2 pitch = 2.0f * building_radius * 1.05f;
+	//two buildings overlap when their centers are within this distance on both axes:
+	reach = 2.0f * building_radius;
+
+	glm::vec2 extent = glm::max(max_ - min_, glm::vec2(0.0f));
+	for (int axis = 0; axis < 2; ++axis) {
+		count[axis] = int32_t(std::floor(extent[axis] / pitch[axis])) + 1;
+		//spread slots evenly over the whole region:
+		spacing[axis] = (count[axis] > 1 ? extent[axis] / (count[axis] - 1) : 0.0f);
+	}
+
+	uint32_t total = uint32_t(count.x * count.y);
+	blockers.assign(total, 0);
+	free.resize(total);
+	free_index.resize(total);
+	for (uint32_t slot = 0; slot < total; ++slot) {
+		free[slot] = slot;
+		free_index[slot] = slot;
+	}
+}
+
+template< typename F >
+void PlacementMap::for_blocked(glm::vec2 const &position, F const &fn) {
+	glm::ivec2 lo, hi;
+	for (int axis = 0; axis < 2; ++axis) {
+		if (spacing[axis] == 0.0f) {
+			lo[axis] = 0;
+			hi[axis] = count[axis] - 1;
+		} else {
+			//(one slot of slack either way; the exact test below decides)
+			lo[axis] = int32_t(std::floor((position[axis] - reach[axis] - min[axis]) / spacing[axis])) - 1;
+			hi[axis] = int32_t(std::ceil((position[axis] + reach[axis] - min[axis]) / spacing[axis])) + 1;
+			lo[axis] = std::max(lo[axis], 0);
+			hi[axis] = std::min(hi[axis], count[axis] - 1);
+		}
+	}
+	for (int32_t y = lo.y; y <= hi.y; ++y) {
+		for (int32_t x = lo.x; x <= hi.x; ++x) {
+			uint32_t slot = uint32_t(y * count.x + x);
+			glm::vec2 at = slot_center(slot);
+			//same test as PongSim::overlaps for two equal-sized boxes:
+			if (std::abs(at.x - position.x) <= reach.x && std::abs(at.y - position.y) <= reach.y) {
+				fn(slot);
+			}
+		}
+	}
+}
+
+void PlacementMap::add(glm::vec2 const &position) {
+	for_blocked(position, [this](uint32_t slot) {
+		if (blockers[slot] == 0) {
+			//remove from free list (swap-and-pop):
+			uint32_t i = free_index[slot];
+			free[i] = free.back();
+			free_index[free[i]] = i;
+			free.pop_back();
+		}
+		assert(blockers[slot] < 0xffff);
+		blockers[slot] += 1;
+	});
+}
+
+void PlacementMap::remove(glm::vec2 const &position) {
+	for_blocked(position, [this](uint32_t slot) {
+		assert(blockers[slot] > 0);
+		blockers[slot] -= 1;
+		if (blockers[slot] == 0) {
+			free_index[slot] = uint32_t(free.size());
+			free.emplace_back(slot);
+		}
+	});
+}
+
+glm::vec2 PlacementMap::random_free(std::mt19937 &mt) const {
+	assert(!free.empty());
+	return slot_center(free[mt() % free.size()]);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+#include <cstdint>
+
+/*
+ * PlacementMap tracks which candidate building positions in a region are free.
+ *
+ * The region (of allowed building centers) is covered by a lattice of slots
+ *  spaced just over one building apart. Each slot counts the buildings that
+ *  would overlap a building placed there; slots with a zero count are kept in
+ *  a packed free list, so picking a random free slot (or noticing there are
+ *  none) is O(1) and adding/removing a building only touches nearby slots.
+ */
+
+struct PlacementMap {
+	//slots cover building centers in [min,max]; buildings are boxes of half-size 'building_radius':
+	PlacementMap(glm::vec2 const &min, glm::vec2 const &max, glm::vec2 const &building_radius);
+
+	//a building (anywhere, not necessarily at a slot) was placed / removed at 'position':
+	void add(glm::vec2 const &position);
+	void remove(glm::vec2 const &position);
+
+	bool full() const { return free.empty(); }
+	size_t free_count() const { return free.size(); }
+
+	//center of a uniformly-chosen free slot (map must not be full):
+	glm::vec2 random_free(std::mt19937 &mt) const;
+
+	//----- internals -----
+	glm::vec2 min;
+	glm::vec2 spacing; //distance between slot centers
+	glm::ivec2 count; //slots in x and y
+	glm::vec2 reach; //slot is blocked by buildings whose centers are within this distance (per axis)
+
+	std::vector< uint16_t > blockers; //per slot: number of buildings overlapping it
+	std::vector< uint32_t > free; //slots with no blockers
+	std::vector< uint32_t > free_index; //per slot: its index in 'free' (if free)
+
+	glm::vec2 slot_center(uint32_t slot) const {
+		return min + spacing * glm::vec2(float(slot % count.x), float(slot / count.x));
+	}
+	//call fn(slot) for every slot a building at 'position' blocks:
+	template< typename F >
+	void for_blocked(glm::vec2 const &position, F const &fn);
+};
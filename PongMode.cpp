@@ -6,117 +6,227 @@
 //for glm::value_ptr() :
 #include <glm/gtc/type_ptr.hpp>
 
-#include <random>
-
-PongMode::PongMode() {
-
-	srand((unsigned int) time(NULL));
-
-	//set up trail as if ball has been here for 'forever':
-	ball_trail.clear();
-	ball_trail.emplace_back(ball, trail_length);
-	ball_trail.emplace_back(ball, 0.0f);
-
-	
-	//----- allocate OpenGL resources -----
-	{ //vertex buffer:
-		glGenBuffers(1, &vertex_buffer);
-		//for now, buffer will be un-filled.
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <new>
+#include <string>
+
+//some nice colors from the course web page:
+#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
+static const glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x193b59ff);
+static const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xf2d2b6ff);
+static const glm::u8vec4 shadow_color = HEX_TO_U8VEC4(0xf2ad94ff);
+static const glm::u8vec4 valid_color = HEX_TO_U8VEC4(0x00ff0080);
+static const glm::u8vec4 invalid_color = HEX_TO_U8VEC4(0xff000080);
+static const glm::u8vec4 money_color = HEX_TO_U8VEC4(0xffee00ff);
+static const glm::u8vec4 shooter_color1 = HEX_TO_U8VEC4(0xffffffff);
+static const glm::u8vec4 shooter_color2 = HEX_TO_U8VEC4(0x000000ff);
+static const glm::u8vec4 wall_color = HEX_TO_U8VEC4(0xffffffff);
+static const glm::u8vec4 farm_color1 = HEX_TO_U8VEC4(0x0db507ff);
+static const glm::u8vec4 farm_color2 = HEX_TO_U8VEC4(0xbd6f17ff);
+static const std::vector< glm::u8vec4 > trail_colors = {
+	HEX_TO_U8VEC4(0xf2ad9488),
+	HEX_TO_U8VEC4(0xf2897288),
+	HEX_TO_U8VEC4(0xbacac088),
+};
+#undef HEX_TO_U8VEC4
+
+//court walls (drawn around the outside of the court):
+static const float wall_radius = 0.05f;
+static const float shadow_offset = 0.07f;
+
+//write the rectangles (at most BUILDING_RECTS) that make up a building of 'type' to 'out'; returns how many:
+static uint32_t make_building_rects(int type, glm::vec2 const &pos, glm::vec2 const &radius, RectInstance *out) {
+	switch (type) {
+		case BUILDING_SHOOTER:
+			new (out+0) RectInstance(pos, radius, shooter_color1);
+			new (out+1) RectInstance(pos, radius / 2.0f, shooter_color2);
+			return 2;
+		case BUILDING_WALL:
+			new (out+0) RectInstance(pos, radius, wall_color);
+			return 1;
+		case BUILDING_FARM:
+			new (out+0) RectInstance(pos, radius, farm_color1);
+			new (out+1) RectInstance(pos, glm::vec2(radius.x / 4.0f, radius.y), farm_color2);
+			new (out+2) RectInstance(pos, glm::vec2(radius.x, radius.y / 4.0f), farm_color2);
+			return 3;
+	}
+	return 0;
+}
 
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+//court walls, in the order they are stored in court_buffer (shadows first):
+static std::vector< RectInstance > court_rects(glm::vec2 const &court_radius) {
+	std::vector< glm::vec2 > centers{
+		glm::vec2(-court_radius.x-wall_radius, 0.0f),
+		glm::vec2( court_radius.x+wall_radius, 0.0f),
+		glm::vec2( 0.0f,-court_radius.y-wall_radius),
+		glm::vec2( 0.0f, court_radius.y+wall_radius),
+	};
+	std::vector< glm::vec2 > radii{
+		glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius),
+		glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius),
+		glm::vec2(court_radius.x, wall_radius),
+		glm::vec2(court_radius.x, wall_radius),
+	};
+	std::vector< RectInstance > rects;
+	for (uint32_t i = 0; i < 4; ++i) {
+		rects.emplace_back(centers[i] + glm::vec2(0.0f,-shadow_offset), radii[i], shadow_color);
 	}
+	for (uint32_t i = 0; i < 4; ++i) {
+		rects.emplace_back(centers[i], radii[i], fg_color);
+	}
+	return rects;
+}
 
-	{ //vertex array mapping buffer for color_texture_program:
-		//ask OpenGL to fill vertex_buffer_for_color_texture_program with the name of an unused vertex array object:
-		glGenVertexArrays(1, &vertex_buffer_for_color_texture_program);
+StreamBuffer::Method PongMode::vertex_upload = StreamBuffer::Ring;
+std::string PongMode::gpu_times_csv;
+uint32_t PongMode::trail_steps = 20;
 
-		//set vertex_buffer_for_color_texture_program as the current vertex array object:
-		glBindVertexArray(vertex_buffer_for_color_texture_program);
+PongMode::PongMode() : PongMode(uint32_t(time(NULL))) {
+}
 
-		//set vertex_buffer as the source of glVertexAttribPointer() commands:
-		glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+PongMode::PongMode(uint32_t seed) : sim(seed) {
 
-		//set up the vertex array object to describe arrays of PongMode::Vertex:
-		glVertexAttribPointer(
-			color_texture_program.Position_vec4, //attribute
-			3, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 0 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Position_vec4);
-		//[Note that it is okay to bind a vec3 input to a vec4 attribute -- the w component will be filled with 1.0 automatically]
-
-		glVertexAttribPointer(
-			color_texture_program.Color_vec4, //attribute
-			4, //size
-			GL_UNSIGNED_BYTE, //type
-			GL_TRUE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.Color_vec4);
-
-		glVertexAttribPointer(
-			color_texture_program.TexCoord_vec2, //attribute
-			2, //size
-			GL_FLOAT, //type
-			GL_FALSE, //normalized
-			sizeof(Vertex), //stride
-			(GLbyte *)0 + 4*3 + 4*1 //offset
-		);
-		glEnableVertexAttribArray(color_texture_program.TexCoord_vec2);
+	//----- allocate OpenGL resources -----
+	//(anything still alive from a previous PongMode is reused, see GLResources)
+
+	{ //programs:
+		color_texture_program = GLResources::get< ColorTextureProgram const >("ColorTextureProgram", [](){
+			return std::make_shared< ColorTextureProgram const >();
+		});
+		rect_instance_program = GLResources::get< RectInstanceProgram const >("RectInstanceProgram", [](){
+			return std::make_shared< RectInstanceProgram const >();
+		});
+		trail_program = GLResources::get< TrailProgram const >("TrailProgram", [](){
+			return std::make_shared< TrailProgram const >();
+		});
+	}
 
-		//done referring to vertex_buffer, so unbind it:
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	{ //drawing helpers built on the programs:
+		hud_text = GLResources::get< HudText >("HudText:" + std::to_string(LABEL_COUNT), [this](){
+			return std::make_shared< HudText >(color_texture_program, LABEL_COUNT);
+		});
+		draw_list = GLResources::get< DrawList >(vertex_upload == StreamBuffer::Ring ? "DrawList:ring" : "DrawList:orphan", [this](){
+			return std::make_shared< DrawList >(rect_instance_program, vertex_upload);
+		});
+		gpu_timer = GLResources::get< GPUTimer >("GPUTimer", [](){
+			std::shared_ptr< GPUTimer > timer = std::make_shared< GPUTimer >();
+			if (!gpu_times_csv.empty()) timer->log_csv(gpu_times_csv);
+			return timer;
+		});
+	}
 
-		//done setting up vertex array object, so unbind it:
-		glBindVertexArray(0);
+	{ //retained layers:
+		//court walls never change, so upload them once (per court size):
+		court_buffer = GLResources::get< GLBuffer >("court:" + std::to_string(sim.court_radius.x) + "x" + std::to_string(sim.court_radius.y), [this](){
+			std::vector< RectInstance > court = court_rects(sim.court_radius);
+			std::shared_ptr< GLBuffer > buffer = std::make_shared< GLBuffer >();
+			glBindBuffer(GL_ARRAY_BUFFER, buffer->name);
+			glBufferData(GL_ARRAY_BUFFER, court.size() * sizeof(court[0]), court.data(), GL_STATIC_DRAW);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			return buffer;
+		});
+
+		//buildings are patched in draw() as they come and go:
+		glGenBuffers(1, &buildings_buffer);
+		sim.buildings.log_changes = true;
+
+		//the trail ring is patched in draw() as samples arrive:
+		glBindBuffer(GL_TEXTURE_BUFFER, trail_buffer.name);
+		glBufferData(GL_TEXTURE_BUFFER, BallTrail::Capacity * sizeof(BallTrail::Sample), nullptr, GL_DYNAMIC_DRAW);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_BUFFER, trail_tex.name);
+		glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, trail_buffer.name);
+		glBindTexture(GL_TEXTURE_BUFFER, 0);
 
 		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
 	}
+}
 
-	{ //solid white texture:
-		//ask OpenGL to fill white_tex with the name of an unused texture object:
-		glGenTextures(1, &white_tex);
-
-		//bind that texture object as a GL_TEXTURE_2D-type texture:
-		glBindTexture(GL_TEXTURE_2D, white_tex);
+PongMode::~PongMode() {
 
-		//upload a 1x1 image of solid white to the texture:
-		glm::uvec2 size = glm::uvec2(1,1);
-		std::vector< glm::u8vec4 > data(size.x*size.y, glm::u8vec4(0xff, 0xff, 0xff, 0xff));
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
+	//----- free OpenGL resources -----
+	//(shared resources are freed by their last user)
 
-		//set filtering and wrapping parameters:
-		//(it's a bit silly to mipmap a 1x1 texture, but I'm doing it because you may want to use this code to load different sizes of texture)
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glDeleteBuffers(1, &buildings_buffer);
+	buildings_buffer = 0;
+}
 
-		//since texture uses a mipmap and we haven't uploaded one, instruct opengl to make one for us:
-		glGenerateMipmap(GL_TEXTURE_2D);
+void PongMode::update_buildings_layer() {
+	std::vector< uint32_t > &changed = sim.buildings.changed_slots;
+	if (changed.empty()) return;
+
+	//make room for every slot (growing re-uploads the whole layer):
+	size_t needed = sim.buildings.slots.size() * BUILDING_RECTS;
+	bool grew = false;
+	if (needed > buildings_rects.size()) {
+		size_t capacity = std::max(needed, 2 * buildings_rects.size());
+		buildings_rects.resize(capacity, RectInstance(glm::vec2(0.0f), glm::vec2(0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0x00)));
+		grew = true;
+	}
 
-		//Okay, texture uploaded, can unbind it:
-		glBindTexture(GL_TEXTURE_2D, 0);
+	std::sort(changed.begin(), changed.end());
+	changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
 
-		GL_ERRORS(); //PARANOIA: print out any OpenGL errors that may have happened
+	//rewrite changed slots (unused rectangles, and slots without a building, are zero-sized):
+	for (uint32_t slot : changed) {
+		RectInstance *out = &buildings_rects[slot * BUILDING_RECTS];
+		uint32_t count = 0;
+		uint32_t i = sim.buildings.slots[slot].index;
+		if (i != -1U) {
+			count = make_building_rects(std::abs(sim.buildings.types[i]), sim.buildings.positions[i], sim.building_radius, out);
+		}
+		for (; count < BUILDING_RECTS; ++count) {
+			out[count].Radius = glm::vec2(0.0f);
+		}
 	}
-}
 
-PongMode::~PongMode() {
+	glBindBuffer(GL_ARRAY_BUFFER, buildings_buffer);
+	if (grew) {
+		glBufferData(GL_ARRAY_BUFFER, buildings_rects.size() * sizeof(RectInstance), buildings_rects.data(), GL_DYNAMIC_DRAW);
+		layer_upload_bytes += buildings_rects.size() * sizeof(RectInstance);
+	} else {
+		//upload runs of adjacent changed slots:
+		for (size_t begin = 0; begin < changed.size(); ) {
+			size_t end = begin + 1;
+			while (end < changed.size() && changed[end] == changed[end-1] + 1) ++end;
+			size_t first = changed[begin] * BUILDING_RECTS;
+			size_t count = (end - begin) * BUILDING_RECTS;
+			glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(RectInstance), count * sizeof(RectInstance), &buildings_rects[first]);
+			layer_upload_bytes += count * sizeof(RectInstance);
+			begin = end;
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	//----- free OpenGL resources -----
-	glDeleteBuffers(1, &vertex_buffer);
-	vertex_buffer = 0;
+	changed.clear();
+}
 
-	glDeleteVertexArrays(1, &vertex_buffer_for_color_texture_program);
-	vertex_buffer_for_color_texture_program = 0;
+void PongMode::update_trail_layer() {
+	BallTrail const &trail = sim.ball_trail;
+	if (trail_uploaded > trail.written) trail_uploaded = 0; //(trail was reset)
+
+	//re-send the newest sample already uploaded (push() may have moved it), then any new ones:
+	uint32_t from = (trail_uploaded == 0 ? 0 : trail_uploaded - 1);
+	if (trail.written - from > BallTrail::Capacity) from = trail.written - BallTrail::Capacity;
+	if (from == trail.written) return;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, trail_buffer.name);
+	while (from != trail.written) {
+		//(at most two runs, split where the ring wraps)
+		uint32_t slot = from % BallTrail::Capacity;
+		uint32_t count = std::min(trail.written - from, BallTrail::Capacity - slot);
+		glBufferSubData(GL_TEXTURE_BUFFER, slot * sizeof(BallTrail::Sample), count * sizeof(BallTrail::Sample), &trail.samples[slot]);
+		layer_upload_bytes += count * sizeof(BallTrail::Sample);
+		from += count;
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
 
-	glDeleteTextures(1, &white_tex);
-	white_tex = 0;
+	trail_uploaded = trail.written;
 }
 
 bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size) {
@@ -128,36 +238,12 @@ bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 		);
 		cursor_pos = clip_to_court * glm::vec3(clip_mouse, 1.0f);
 
-		left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
+		sim.left_paddle.y = (clip_to_court * glm::vec3(clip_mouse, 1.0f)).y;
+		previous_left_paddle.y = sim.left_paddle.y; //(the mouse-driven paddle shouldn't lag behind the mouse)
 	}
 	if (evt.type == SDL_MOUSEBUTTONUP){
-		if(cursor_mode != CURSOR_NORMAL && !overlaps_buildings(cursor_pos,building_radius) && in_base(cursor_pos,building_radius)){
-			switch(cursor_mode){
-				case BUILDING_SHOOTER:
-					if(cursor_mode == BUILDING_SHOOTER && left_money >= SHOOTER_PRICE){
-						building_cooldowns.push_back(SHOOTER_COOL);
-						buildings.push_back(glm::vec2(cursor_pos.x,cursor_pos.y));
-						building_types.push_back(cursor_mode);
-						left_money -= SHOOTER_PRICE;
-					}
-					break;
-				case BUILDING_WALL:
-					if(left_money >= WALL_PRICE){
-						buildings.push_back(glm::vec2(cursor_pos.x,cursor_pos.y));
-						building_types.push_back(cursor_mode);
-						building_cooldowns.push_back(WALL_COOL);
-						left_money -= WALL_PRICE;
-					}
-					break;
-				case BUILDING_FARM:
-					if (left_money >= FARM_PRICE){
-						building_cooldowns.push_back(FARM_COOL);
-						buildings.push_back(glm::vec2(cursor_pos.x,cursor_pos.y));
-						building_types.push_back(cursor_mode);
-						left_money -= FARM_PRICE;
-					}
-					break;
-			}
+		if(cursor_mode != CURSOR_NORMAL && !sim.overlaps_buildings(cursor_pos,sim.building_radius) && sim.in_base(cursor_pos,sim.building_radius)){
+			sim.place_building(SIDE_LEFT, cursor_mode, cursor_pos);
 		}
 	}
 
@@ -174,565 +260,162 @@ bool PongMode::handle_event(SDL_Event const &evt, glm::uvec2 const &window_size)
 		else if(evt.key.keysym.sym == SDLK_e){
 			cursor_mode = BUILDING_FARM;
 		}
+		else if(evt.key.keysym.sym == SDLK_F2){
+			print_draw_stats = !print_draw_stats;
+		}
 	}
 
 	return false;
 }
 
 void PongMode::update(float elapsed) {
+	previous_ball = sim.ball;
+	previous_left_paddle = sim.left_paddle;
+	previous_right_paddle = sim.right_paddle;
+	last_elapsed = elapsed;
 
-	static std::mt19937 mt; //mersenne twister pseudo-random number generator
+	sim.update(elapsed);
 
-	//----- paddle update -----
-
-	{ //right player ai:
-		ai_offset_update -= elapsed;
-		if (ai_offset_update < elapsed) {
-			//update again in [0.5,1.0) seconds:
-			ai_offset_update = (mt() / float(mt.max())) * 0.5f + 0.5f;
-			ai_offset = (mt() / float(mt.max())) * 2.5f - 1.25f;
-		}
-		if(ball.x < right_paddle.x){
-			if (right_paddle.y < ball.y + ai_offset) {
-				right_paddle.y = std::min(ball.y + ai_offset, right_paddle.y + 2.0f * elapsed);
-			} else {
-				right_paddle.y = std::max(ball.y + ai_offset, right_paddle.y - 2.0f * elapsed);
-			}
-		}
-		//Avoid ball if behind the paddle
-		else{
-			if (right_paddle.y < ball.y + ai_offset) {
-				right_paddle.y = std::min(ball.y + ai_offset, right_paddle.y - 2.0f * elapsed);
-			} else {
-				right_paddle.y = std::max(ball.y + ai_offset, right_paddle.y + 2.0f * elapsed);
-			}
-		}
-
-		if(enough_money()){
-			int tries = 0;
-			while(tries++ < 1000){
-				//Random number generation from https://stackoverflow.com/questions/686353/random-float-number-generation
-				float x = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-				x = court_radius.x - x * (base_length - 2.0f * building_radius.x - buffer_radius) - building_radius.x;
-				float y = static_cast <float> (rand()) / static_cast <float> (RAND_MAX);
-				y = (2.0f * y - 1.0f) * (court_radius.y - 2.0f * building_radius.y);
-
-				glm::vec2 pos = glm::vec2(x,y);
-				if(!overlaps_buildings(pos, building_radius)){
-					switch(next_purchase){
-						case BUILDING_SHOOTER:
-							if(right_money >= SHOOTER_PRICE){
-								building_cooldowns.push_back(SHOOTER_COOL);
-								buildings.push_back(glm::vec2(pos.x,pos.y));
-								building_types.push_back(-1 * BUILDING_SHOOTER);
-								right_money -= SHOOTER_PRICE;
-							}
-							break;
-						case BUILDING_WALL:
-							if(right_money >= WALL_PRICE){
-								buildings.push_back(glm::vec2(pos.x,pos.y));
-								building_types.push_back(BUILDING_WALL);
-								building_cooldowns.push_back(WALL_COOL);
-								right_money -= WALL_PRICE;
-							}
-							break;
-						case BUILDING_FARM:
-							if (right_money >= FARM_PRICE){
-								building_cooldowns.push_back(FARM_COOL);
-								buildings.push_back(glm::vec2(pos.x,pos.y));
-								building_types.push_back(-1 * BUILDING_FARM);
-								right_money -= FARM_PRICE;
-							}
-							break;
-					}
-					
-					next_purchase = rand() % 3 + 1;
-
-					break;
-				}
-			}
-		}
-	}
-
-	//passive income
-	income_cooldown -= elapsed;
-	while(income_cooldown < 0){
-		income_cooldown += INCOME_COOL;
-		left_money++;
-		right_money++;
-	}
-
-	//clamp paddles to court:
-	right_paddle.y = std::max(right_paddle.y, -court_radius.y + paddle_radius.y);
-	right_paddle.y = std::min(right_paddle.y,  court_radius.y - paddle_radius.y);
-
-	left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
-	left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
-
-	//----- ball update -----
-
-	//speed of ball increases every second:
-	float speed_multiplier = 4.0f * std::pow(2.0f, (left_score + right_score) / 4.0f);
-
-	//velocity cap, though (otherwise ball can pass through paddles):
-	speed_multiplier = std::min(speed_multiplier, 10.0f);
-
-	ball += elapsed * speed_multiplier * ball_velocity;
-
-	//---- building cooldowns ----
-	for(size_t i=0;i<buildings.size();i++){
-		building_cooldowns[i] -= elapsed;
-		while(building_cooldowns[i] < 0){
-			switch(abs(building_types[i])){
-				case BUILDING_SHOOTER:
-					//spawn bullet
-					if(building_types[i] == BUILDING_SHOOTER){
-						glm::vec2 pos = glm::vec2(buildings[i].x, buildings[i].y);
-						pos.x += building_radius.x + 2.0f * bullet_radius.x;
-						left_bullets.push_back(pos);
-					}
-					else{
-						glm::vec2 pos = glm::vec2(buildings[i].x, buildings[i].y);
-						pos.x -= building_radius.x + 2.0f * bullet_radius.x;
-						right_bullets.push_back(pos);
-					}
-					building_cooldowns[i] += SHOOTER_COOL;
-					break;
-				case BUILDING_WALL:
-					building_cooldowns[i] += WALL_COOL;
-					break;
-				case BUILDING_FARM:
-					//Increase money
-					if(building_types[i] == BUILDING_FARM){
-						left_money++;
-					}
-					else{
-						right_money++;
-					}
-					building_cooldowns[i] += FARM_COOL;
-					break;
-			}
-		}
-	}
-
-	for(size_t i=0;i<left_bullets.size();i++){
-		left_bullets[i].x += elapsed * bullet_speed;
-	}
-	for(size_t i=0;i<right_bullets.size();i++){
-		right_bullets[i].x -= elapsed * bullet_speed;
-	}
-
-
-	//---- collision handling ----
-
-	//paddles:
-	auto paddle_vs_ball = [this](glm::vec2 const &paddle) {
-		//compute area of overlap:
-		glm::vec2 min = glm::max(paddle - paddle_radius, ball - ball_radius);
-		glm::vec2 max = glm::min(paddle + paddle_radius, ball + ball_radius);
-
-		//if no overlap, no collision:
-		if (min.x > max.x || min.y > max.y) return;
-
-		if (max.x - min.x > max.y - min.y) {
-			//wider overlap in x => bounce in y direction:
-			if (ball.y > paddle.y) {
-				ball.y = paddle.y + paddle_radius.y + ball_radius.y;
-				ball_velocity.y = std::abs(ball_velocity.y);
-			} else {
-				ball.y = paddle.y - paddle_radius.y - ball_radius.y;
-				ball_velocity.y = -std::abs(ball_velocity.y);
-			}
-		} else {
-			//wider overlap in y => bounce in x direction:
-			if (ball.x > paddle.x) {
-				ball.x = paddle.x + paddle_radius.x + ball_radius.x;
-				ball_velocity.x = std::abs(ball_velocity.x);
-			} else {
-				ball.x = paddle.x - paddle_radius.x - ball_radius.x;
-				ball_velocity.x = -std::abs(ball_velocity.x);
-			}
-			//warp y velocity based on offset from paddle center:
-			float vel = (ball.y - paddle.y) / (paddle_radius.y + ball_radius.y);
-			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
-		}
-	};
-	paddle_vs_ball(left_paddle);
-	paddle_vs_ball(right_paddle);
-
-	for(size_t i=0;i<buildings.size();i++){
-		if(overlaps(ball,ball_radius,buildings[i],building_radius)){
-			//Bounce back if hit wall
-			if(abs(building_types[i]) == BUILDING_WALL){
-				//Collision detection from above
-				glm::vec2 min = glm::max(buildings[i] - building_radius, ball - ball_radius);
-				glm::vec2 max = glm::min(buildings[i] + building_radius, ball + ball_radius);
-
-				//if no overlap, no collision:
-				if (min.x > max.x || min.y > max.y) return;
-
-				if (max.x - min.x > max.y - min.y) {
-					//wider overlap in x => bounce in y direction:
-					if (ball.y > buildings[i].y) {
-						ball.y = buildings[i].y + building_radius.y + ball_radius.y;
-						ball_velocity.y = std::abs(ball_velocity.y);
-					} else {
-						ball.y = buildings[i].y - building_radius.y - ball_radius.y;
-						ball_velocity.y = -std::abs(ball_velocity.y);
-					}
-				} else {
-					//wider overlap in y => bounce in x direction:
-					if (ball.x > buildings[i].x) {
-						ball.x = buildings[i].x + building_radius.x + ball_radius.x;
-						ball_velocity.x = std::abs(ball_velocity.x);
-					} else {
-						ball.x = buildings[i].x - building_radius.x - ball_radius.x;
-						ball_velocity.x = -std::abs(ball_velocity.x);
-					}
-					//warp y velocity based on offset from buildings[i] center:
-					float vel = (ball.y - buildings[i].y) / (building_radius.y + ball_radius.y);
-					ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
-				}
-
-			}
-			buildings.erase(buildings.begin() + i);
-			building_types.erase(building_types.begin() + i);
-		}
-	}
-
-
-	//court walls:
-	if (ball.y > court_radius.y - ball_radius.y) {
-		ball.y = court_radius.y - ball_radius.y;
-		if (ball_velocity.y > 0.0f) {
-			ball_velocity.y = -ball_velocity.y;
-		}
-	}
-	if (ball.y < -court_radius.y + ball_radius.y) {
-		ball.y = -court_radius.y + ball_radius.y;
-		if (ball_velocity.y < 0.0f) {
-			ball_velocity.y = -ball_velocity.y;
-		}
-	}
-
-	if (ball.x > court_radius.x - ball_radius.x) {
-		ball.x = court_radius.x - ball_radius.x;
-		if (ball_velocity.x > 0.0f) {
-			ball_velocity.x = -ball_velocity.x;
-			right_health -= 10;
-			if(right_health < 0){
-				right_health = 0;
-			}
-		}
-	}
-	if (ball.x < -court_radius.x + ball_radius.x) {
-		ball.x = -court_radius.x + ball_radius.x;
-		if (ball_velocity.x < 0.0f) {
-			ball_velocity.x = -ball_velocity.x;
-			left_health -= 10;
-			if(left_health < 0){
-				left_health = 0;
-			}
-		}
-	}
-
-	//Bullet collisions
-	
-	for(size_t i=0;i<left_bullets.size();i++){
-		//walls from above
-		if (left_bullets[i].x > court_radius.x - bullet_radius.x) {
-			left_bullets.erase(left_bullets.begin() + i);
-			right_health -= 5;
-			if(right_health < 0){
-				right_health = 0;
-			}
-		}
-
-		//Paddles
-		if(overlaps(left_paddle,paddle_radius,left_bullets[i], bullet_radius) ||
-		   overlaps(right_paddle,paddle_radius,left_bullets[i], bullet_radius)){
-			left_bullets.erase(left_bullets.begin() + i);
-		}
-
-		//Buildings
-		for(size_t j=0;j<buildings.size();j++){
-			if(overlaps(buildings[j],building_radius,left_bullets[i],bullet_radius)){
-				if(abs(building_types[j]) != BUILDING_WALL){
-					buildings.erase(buildings.begin() + j);
-					building_types.erase(building_types.begin() + j);
-
-				}
-				left_bullets.erase(left_bullets.begin() + i);
-			}
-
-		}
-	}
-
-	for(size_t i=0;i<right_bullets.size();i++){
-		//walls from above
-		if (right_bullets[i].x < -court_radius.x + bullet_radius.x) {
-			std::cout << "here\n" << std::endl;
-			right_bullets.erase(right_bullets.begin() + i);
-			left_health -= 5;
-			if(left_health < 0){
-				left_health = 0;
-			}
-		}
-
-		//Paddles
-		if(overlaps(left_paddle,paddle_radius,right_bullets[i], bullet_radius) ||
-		   overlaps(right_paddle,paddle_radius,right_bullets[i], bullet_radius)){
-			right_bullets.erase(right_bullets.begin() + i);
-		}
-
-		//Buildings
-		for(size_t j=0;j<buildings.size();j++){
-			if(overlaps(buildings[j],building_radius,right_bullets[i],bullet_radius)){
-				if(abs(building_types[j]) != BUILDING_WALL){
-					buildings.erase(buildings.begin() + j);
-					building_types.erase(building_types.begin() + j);
-
-				}
-				right_bullets.erase(right_bullets.begin() + i);
-			}
-
-		}
-	}
-	
-	
-	//----- gradient trails -----
-
-	//age up all locations in ball trail:
-	for (auto &t : ball_trail) {
-		t.z += elapsed;
-	}
-	//store fresh location at back of ball trail:
-	ball_trail.emplace_back(ball, 0.0f);
-
-	//trim any too-old locations from back of trail:
-	//NOTE: since trail drawing interpolates between points, only removes back element if second-to-back element is too old:
-	while (ball_trail.size() >= 2 && ball_trail[1].z > trail_length) {
-		ball_trail.pop_front();
-	}
-
-	if(left_health == 0 || right_health == 0){
+	if(sim.game_over()){
 		Mode::set_current(std::make_shared< PongMode >());
 	}
 }
 
+void PongMode::set_tick_fraction(float fraction) {
+	tick_fraction = fraction;
+}
+
 void PongMode::draw(glm::uvec2 const &drawable_size) {
-	//some nice colors from the course web page:
-	#define HEX_TO_U8VEC4( HX ) (glm::u8vec4( (HX >> 24) & 0xff, (HX >> 16) & 0xff, (HX >> 8) & 0xff, (HX) & 0xff ))
-	const glm::u8vec4 bg_color = HEX_TO_U8VEC4(0x193b59ff);
-	const glm::u8vec4 fg_color = HEX_TO_U8VEC4(0xf2d2b6ff);
-	const glm::u8vec4 shadow_color = HEX_TO_U8VEC4(0xf2ad94ff);
-	const glm::u8vec4 valid_color = HEX_TO_U8VEC4(0x00ff0080);
-	const glm::u8vec4 invalid_color = HEX_TO_U8VEC4(0xff000080);
-	const glm::u8vec4 money_color = HEX_TO_U8VEC4(0xffee00ff);
-	const glm::u8vec4 shooter_color1 = HEX_TO_U8VEC4(0xffffffff);
-	const glm::u8vec4 shooter_color2 = HEX_TO_U8VEC4(0x000000ff);
-	const glm::u8vec4 wall_color = HEX_TO_U8VEC4(0xffffffff);
-	const glm::u8vec4 farm_color1 = HEX_TO_U8VEC4(0x0db507ff);
-	const glm::u8vec4 farm_color2 = HEX_TO_U8VEC4(0xbd6f17ff);
-	const std::vector< glm::u8vec4 > trail_colors = {
-		HEX_TO_U8VEC4(0xf2ad9488),
-		HEX_TO_U8VEC4(0xf2897288),
-		HEX_TO_U8VEC4(0xbacac088),
+	//CPU time per phase, for draw_ms:
+	typedef std::chrono::high_resolution_clock Clock;
+	auto ms_since = [](Clock::time_point const &then) {
+		return std::chrono::duration< float, std::milli >(Clock::now() - then).count();
 	};
-	#undef HEX_TO_U8VEC4
+	Clock::time_point phase_start = Clock::now();
+	layer_upload_bytes = 0;
 
 	//other useful drawing constants:
-	const float wall_radius = 0.05f;
-	const float shadow_offset = 0.07f;
 	const float padding = 0.14f; //padding between outside of walls and edge of window
 
 	//---- compute vertices to draw ----
 
-	//vertices will be accumulated into this list and then uploaded+drawn at the end of this function:
-	std::vector< Vertex > vertices;
+	//the court and buildings are retained layers (court_buffer, buildings_buffer), so
+	// only moving things are streamed per frame; everything is submitted to draw_list,
+	// which sorts by layer (shadow, trail, solid, overlay) and draws at the end of this function.
+
+	//moving things, interpolated between the last two updates:
+	glm::vec2 ball = glm::mix(previous_ball, sim.ball, tick_fraction);
+	glm::vec2 left_paddle = glm::mix(previous_left_paddle, sim.left_paddle, tick_fraction);
+	glm::vec2 right_paddle = glm::mix(previous_right_paddle, sim.right_paddle, tick_fraction);
+	float behind = (1.0f - tick_fraction) * last_elapsed; //seconds between the drawn state and sim's
 
 	//inline helper function for rectangle drawing:
-	auto draw_rectangle = [&vertices](glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
-		//draw rectangle as two CCW-oriented triangles:
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
-		vertices.emplace_back(glm::vec3(center.x-radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+	auto draw_rectangle = [this](DrawList::Layer layer, glm::vec2 const &center, glm::vec2 const &radius, glm::u8vec4 const &color) {
+		draw_list->rect(layer, center, radius, color);
 	};
 
-
-	//shadows for everything (except the trail):
+	//shadows for everything (except the trail and buildings):
 
 	glm::vec2 s = glm::vec2(0.0f,-shadow_offset);
 
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f)+s, glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius)+s, glm::vec2(court_radius.x, wall_radius), shadow_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius)+s, glm::vec2(court_radius.x, wall_radius), shadow_color);
-	draw_rectangle(left_paddle+s, paddle_radius, shadow_color);
-	draw_rectangle(right_paddle+s, paddle_radius, shadow_color);
-	draw_rectangle(ball+s, ball_radius, shadow_color);
-
-	//ball's trail:
-	if (ball_trail.size() >= 2) {
-		//start ti at second element so there is always something before it to interpolate from:
-		std::deque< glm::vec3 >::iterator ti = ball_trail.begin() + 1;
-		//draw trail from oldest-to-newest:
-		constexpr uint32_t STEPS = 20;
-		//draw from [STEPS, ..., 1]:
-		for (uint32_t step = STEPS; step > 0; --step) {
-			//time at which to draw the trail element:
-			float t = step / float(STEPS) * trail_length;
-			//advance ti until 'just before' t:
-			while (ti != ball_trail.end() && ti->z > t) ++ti;
-			//if we ran out of recorded tail, stop drawing:
-			if (ti == ball_trail.end()) break;
-			//interpolate between previous and current trail point to the correct time:
-			glm::vec3 a = *(ti-1);
-			glm::vec3 b = *(ti);
-			glm::vec2 at = (t - a.z) / (b.z - a.z) * (glm::vec2(b) - glm::vec2(a)) + glm::vec2(a);
-
-			//look up color using linear interpolation:
-			//compute (continuous) index:
-			float c = (step-1) / float(STEPS-1) * trail_colors.size();
-			//split into an integer and fractional portion:
-			int32_t ci = int32_t(std::floor(c));
-			float cf = c - ci;
-			//clamp to allowable range (shouldn't ever be needed but good to think about for general interpolation):
-			if (ci < 0) {
-				ci = 0;
-				cf = 0.0f;
-			}
-			if (ci > int32_t(trail_colors.size())-2) {
-				ci = int32_t(trail_colors.size())-2;
-				cf = 1.0f;
+	draw_list->rects(DrawList::LayerShadow, court_buffer->name, 0, 4); //court wall shadows
+	draw_rectangle(DrawList::LayerShadow, left_paddle+s, sim.paddle_radius, shadow_color);
+	draw_rectangle(DrawList::LayerShadow, right_paddle+s, sim.paddle_radius, shadow_color);
+	draw_rectangle(DrawList::LayerShadow, ball+s, sim.ball_radius, shadow_color);
+
+	//ball's trail (interpolated along sim.ball_trail and colored on the GPU; see TrailProgram):
+	if (trail_steps > 0) {
+		uint32_t steps = trail_steps;
+		draw_list->callback(DrawList::LayerTrail, trail_program->program, 0, DrawList::BlendAlpha, 6 * steps, [this,steps,behind](glm::mat4 const &object_to_clip) {
+			BallTrail const &trail = sim.ball_trail;
+
+			glm::vec4 colors[TrailProgram::MaxColors];
+			uint32_t color_count = uint32_t(std::min< size_t >(trail_colors.size(), TrailProgram::MaxColors));
+			for (uint32_t i = 0; i < color_count; ++i) {
+				colors[i] = glm::vec4(trail_colors[i]) / 255.0f;
 			}
-			//do the interpolation (casting to floating point vectors because glm::mix doesn't have an overload for u8 vectors):
-			glm::u8vec4 color = glm::u8vec4(
-				glm::mix(glm::vec4(trail_colors[ci]), glm::vec4(trail_colors[ci+1]), cf)
-			);
 
-			//draw:
-			draw_rectangle(at, ball_radius, color);
-		}
+			glUniformMatrix4fv(trail_program->OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(object_to_clip));
+			glUniform1i(trail_program->FIRST_int, GLint(trail.first() % BallTrail::Capacity));
+			glUniform1i(trail_program->COUNT_int, GLint(trail.size()));
+			glUniform1f(trail_program->NOW_float, float(sim.time) - behind);
+			glUniform1f(trail_program->LENGTH_float, trail.length);
+			glUniform1i(trail_program->STEPS_int, GLint(steps));
+			glUniform2fv(trail_program->RADIUS_vec2, 1, glm::value_ptr(sim.ball_radius));
+			glUniform4fv(trail_program->COLORS_vec4_array, GLsizei(color_count), glm::value_ptr(colors[0]));
+			glUniform1i(trail_program->COLOR_COUNT_int, GLint(color_count));
+
+			glActiveTexture(GL_TEXTURE0);
+			glBindTexture(GL_TEXTURE_BUFFER, trail_tex.name);
+			glBindVertexArray(trail_vao.name);
+
+			glDrawArraysInstanced(GL_TRIANGLES, 0, 6, steps);
+
+			glBindVertexArray(0);
+			glBindTexture(GL_TEXTURE_BUFFER, 0);
+		});
 	}
 
 	//solid objects:
 
 	//walls:
-	draw_rectangle(glm::vec2(-court_radius.x-wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( court_radius.x+wall_radius, 0.0f), glm::vec2(wall_radius, court_radius.y + 2.0f * wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f,-court_radius.y-wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
-	draw_rectangle(glm::vec2( 0.0f, court_radius.y+wall_radius), glm::vec2(court_radius.x, wall_radius), fg_color);
+	draw_list->rects(DrawList::LayerSolid, court_buffer->name, 4, 4);
 
 	//paddles:
-	draw_rectangle(left_paddle, paddle_radius, fg_color);
-	draw_rectangle(right_paddle, paddle_radius, fg_color);
+	draw_rectangle(DrawList::LayerSolid, left_paddle, sim.paddle_radius, fg_color);
+	draw_rectangle(DrawList::LayerSolid, right_paddle, sim.paddle_radius, fg_color);
 	
 
 	//ball:
-	draw_rectangle(ball, ball_radius, fg_color);
+	draw_rectangle(DrawList::LayerSolid, ball, sim.ball_radius, fg_color);
 
 	//buildings:
-	
-	auto draw_shooter = [&](glm::vec2 pos){
-		draw_rectangle(glm::vec2(pos),glm::vec2(building_radius), shooter_color1);
-		draw_rectangle(glm::vec2(pos),glm::vec2(building_radius / 2.0f), shooter_color2);
-	};
-
-	auto draw_wall = [&](glm::vec2 pos){
-		draw_rectangle(glm::vec2(pos),glm::vec2(building_radius), wall_color);
-	};
+	draw_list->rects(DrawList::LayerSolid, buildings_buffer, 0, uint32_t(sim.buildings.slots.size() * BUILDING_RECTS));
 
-	auto draw_farm = [&](glm::vec2 pos){
-		draw_rectangle(glm::vec2(pos),glm::vec2(building_radius), farm_color1);
-		draw_rectangle(glm::vec2(pos),glm::vec2(building_radius.x / 4.0f, building_radius.y), farm_color2);
-		draw_rectangle(glm::vec2(pos),glm::vec2(building_radius.x, building_radius.y / 4.0f), farm_color2);
-	};
-
-	for(size_t i=0;i<buildings.size();i++){
-		switch(abs(building_types[i])){
-			case BUILDING_SHOOTER:
-				draw_shooter(buildings[i]);
-				break;
-			case BUILDING_WALL:
-				draw_wall(buildings[i]);
-				break;
-			case BUILDING_FARM:
-				draw_farm(buildings[i]);
-				break;
-		}
-	}
-
-	//bullets
-	for(size_t i=0;i<left_bullets.size();i++){
-		draw_rectangle(glm::vec2(left_bullets[i]),glm::vec2(bullet_radius), fg_color);
-	}
-	for(size_t i=0;i<right_bullets.size();i++){
-		draw_rectangle(glm::vec2(right_bullets[i]),glm::vec2(bullet_radius), fg_color);
+	//bullets (moved back along their paths to the drawn time)
+	for(uint32_t i=0;i<sim.bullets.count;i++){
+		glm::vec2 at = sim.bullets.position(i) - glm::vec2(sim.bullets.direction[i] * sim.bullet_speed * behind, 0.0f);
+		draw_rectangle(DrawList::LayerSolid, at, glm::vec2(sim.bullet_radius), fg_color);
 	}
 
 	//building outline
-	switch(cursor_mode){
-		case BUILDING_FARM:
-			draw_farm(cursor_pos);
-			if(overlaps_buildings(cursor_pos,building_radius) || !in_base(cursor_pos, building_radius) || left_money < FARM_PRICE){
-				draw_rectangle(cursor_pos,glm::vec2(building_radius), invalid_color);
-			}
-			else{
-				draw_rectangle(cursor_pos,glm::vec2(building_radius), valid_color);
-			}
-			break;
-		case BUILDING_SHOOTER:
-			draw_shooter(cursor_pos);
-			if(overlaps_buildings(cursor_pos,building_radius) || !in_base(cursor_pos, building_radius) || left_money < SHOOTER_PRICE){
-				draw_rectangle(cursor_pos,glm::vec2(building_radius), invalid_color);
-			}
-			else{
-				draw_rectangle(cursor_pos,glm::vec2(building_radius), valid_color);
-			}
-			break;
-			break;
-		case BUILDING_WALL:
-			draw_wall(cursor_pos);
-			if(overlaps_buildings(cursor_pos,building_radius) || !in_base(cursor_pos, building_radius) || left_money < WALL_PRICE){
-				draw_rectangle(cursor_pos,glm::vec2(building_radius), invalid_color);
-			}
-			else{
-				draw_rectangle(cursor_pos,glm::vec2(building_radius), valid_color);
-			}
-			break;
+	if (cursor_mode == BUILDING_FARM || cursor_mode == BUILDING_SHOOTER || cursor_mode == BUILDING_WALL) {
+		RectInstance cursor_rects[BUILDING_RECTS] = {
+			RectInstance(glm::vec2(0.0f), glm::vec2(0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0x00)),
+			RectInstance(glm::vec2(0.0f), glm::vec2(0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0x00)),
+			RectInstance(glm::vec2(0.0f), glm::vec2(0.0f), glm::u8vec4(0x00, 0x00, 0x00, 0x00)),
+		};
+		uint32_t count = make_building_rects(cursor_mode, cursor_pos, sim.building_radius, cursor_rects);
+		for (uint32_t i = 0; i < count; ++i) {
+			draw_rectangle(DrawList::LayerOverlay, cursor_rects[i].Center, cursor_rects[i].Radius, cursor_rects[i].Color);
+		}
+		if(sim.overlaps_buildings(cursor_pos,sim.building_radius) || !sim.in_base(cursor_pos, sim.building_radius) || !sim.enough_money(SIDE_LEFT, cursor_mode)){
+			draw_rectangle(DrawList::LayerOverlay, cursor_pos,glm::vec2(sim.building_radius), invalid_color);
+		}
+		else{
+			draw_rectangle(DrawList::LayerOverlay, cursor_pos,glm::vec2(sim.building_radius), valid_color);
+		}
 	}
 
 	//health:
 	glm::vec2 health_radius = glm::vec2(0.05f, 0.1f);
-	draw_rectangle(glm::vec2(-court_radius.x + health_radius.x * left_health / 2.0f, court_radius.y + 2.0f * wall_radius + 2.0f * health_radius.y),
-	               glm::vec2(health_radius.x * left_health / 2.0f, health_radius.y), fg_color);
-	draw_rectangle(glm::vec2(court_radius.x - health_radius.x * right_health / 2.0f, court_radius.y + 2.0f * wall_radius + 2.0f * health_radius.y),
-	               glm::vec2(health_radius.x * right_health / 2.0f, health_radius.y), fg_color);
+	draw_rectangle(DrawList::LayerOverlay, glm::vec2(-sim.court_radius.x + health_radius.x * sim.left_health / 2.0f, sim.court_radius.y + 2.0f * wall_radius + 2.0f * health_radius.y),
+	               glm::vec2(health_radius.x * sim.left_health / 2.0f, health_radius.y), fg_color);
+	draw_rectangle(DrawList::LayerOverlay, glm::vec2(sim.court_radius.x - health_radius.x * sim.right_health / 2.0f, sim.court_radius.y + 2.0f * wall_radius + 2.0f * health_radius.y),
+	               glm::vec2(health_radius.x * sim.right_health / 2.0f, health_radius.y), fg_color);
 
-	//money - adapted from score drawing code
 	glm::vec2 money_radius = glm::vec2(0.1f, 0.1f);
-	for(uint32_t i = 0; i < left_money; ++i){
-		draw_rectangle(glm::vec2( -court_radius.x + (2.0f + 3.0f * i) * money_radius.x, -court_radius.y - 2.0f * wall_radius - 2.0f * money_radius.y), money_radius, money_color);
-	}
-	for (uint32_t i = 0; i < right_money; ++i) {
-		draw_rectangle(glm::vec2( court_radius.x - (2.0f + 3.0f * i) * money_radius.x, -court_radius.y - 2.0f * wall_radius - 2.0f * money_radius.y), money_radius, money_color);
-	}
 
 	//------ compute court-to-window transform ------
 
 	//compute area that should be visible:
 	glm::vec2 scene_min = glm::vec2(
-		-court_radius.x - 2.0f * wall_radius - padding,
-		-court_radius.y - 2.0f * wall_radius - 2.0f * money_radius.y - padding
+		-sim.court_radius.x - 2.0f * wall_radius - padding,
+		-sim.court_radius.y - 2.0f * wall_radius - 2.0f * money_radius.y - padding
 	);
 	glm::vec2 scene_max = glm::vec2(
-		court_radius.x + 2.0f * wall_radius + padding,
-		court_radius.y + 2.0f * wall_radius + 3.0f * health_radius.y + padding
+		sim.court_radius.x + 2.0f * wall_radius + padding,
+		sim.court_radius.y + 2.0f * wall_radius + 3.0f * health_radius.y + padding
 	);
 
 	//compute window aspect ratio:
@@ -764,48 +447,80 @@ void PongMode::draw(glm::uvec2 const &drawable_size) {
 		glm::vec2(center.x, center.y)
 	);
 
-	//---- actual drawing ----
+	//------ text readouts ------
+	//(laid out after the transform, so glyphs can be snapped to whole drawable pixels)
 
-	//clear the color buffer:
-	glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
-	glClear(GL_COLOR_BUFFER_BIT);
+	//court-space size of a drawable pixel, and the court-space position of the lower-left pixel's corner:
+	hud_text->set_pixel_grid(clip_to_court * glm::vec3(-1.0f, -1.0f, 1.0f), 2.0f / (scale * drawable_size.y));
 
-	//use alpha blending:
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	//don't use the depth test:
-	glDisable(GL_DEPTH_TEST);
+	//health readouts, just past where a full (100) health bar ends:
+	float health_text_x = sim.court_radius.x - health_radius.x * 100.0f - 2.0f * health_radius.y;
+	float health_text_y = sim.court_radius.y + 2.0f * wall_radius + 2.0f * health_radius.y;
+	hud_text->set(LABEL_LEFT_HEALTH, std::to_string(sim.left_health), glm::vec2(-health_text_x, health_text_y), 2.0f * health_radius.y, fg_color, HudText::AlignLeft);
+	hud_text->set(LABEL_RIGHT_HEALTH, std::to_string(sim.right_health), glm::vec2(health_text_x, health_text_y), 2.0f * health_radius.y, fg_color, HudText::AlignRight);
 
-	//upload vertices to vertex_buffer:
-	glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer); //set vertex_buffer as current
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(vertices[0]), vertices.data(), GL_STREAM_DRAW); //upload vertices array
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	//score readouts, on either side of the middle of the court, level with the health readouts:
+	float score_text_x = 2.0f * health_radius.y;
+	hud_text->set(LABEL_LEFT_SCORE, std::to_string(sim.left_score), glm::vec2(-score_text_x, health_text_y), 2.0f * health_radius.y, fg_color, HudText::AlignRight);
+	hud_text->set(LABEL_RIGHT_SCORE, std::to_string(sim.right_score), glm::vec2(score_text_x, health_text_y), 2.0f * health_radius.y, fg_color, HudText::AlignLeft);
 
-	//set color_texture_program as current program:
-	glUseProgram(color_texture_program.program);
+	//money readouts (text, so they don't grow with the amount of money):
+	float money_text_y = -sim.court_radius.y - 2.0f * wall_radius - 2.0f * money_radius.y;
+	hud_text->set(LABEL_LEFT_MONEY, "$" + std::to_string(sim.left_money), glm::vec2(-sim.court_radius.x + money_radius.x, money_text_y), 2.0f * money_radius.y, money_color, HudText::AlignLeft);
+	hud_text->set(LABEL_RIGHT_MONEY, "$" + std::to_string(sim.right_money), glm::vec2(sim.court_radius.x - money_radius.x, money_text_y), 2.0f * money_radius.y, money_color, HudText::AlignRight);
 
-	//upload OBJECT_TO_CLIP to the proper uniform location:
-	glUniformMatrix4fv(color_texture_program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(court_to_clip));
+	draw_list->callback(DrawList::LayerOverlay, color_texture_program->program, hud_text->atlas_tex, DrawList::BlendAlpha,
+		uint32_t(hud_text->vertices.size()), [this](glm::mat4 const &object_to_clip) {
+		hud_text->draw(object_to_clip);
+	});
 
-	//use the mapping vertex_buffer_for_color_texture_program to fetch vertex data:
-	glBindVertexArray(vertex_buffer_for_color_texture_program);
 
-	//bind the solid white texture to location zero so things will be drawn just with their colors:
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, white_tex);
+	//---- actual drawing ----
 
-	//run the OpenGL pipeline:
-	glDrawArrays(GL_TRIANGLES, 0, GLsizei(vertices.size()));
+	draw_ms.submit = ms_since(phase_start);
 
-	//unbind the solid white texture:
-	glBindTexture(GL_TEXTURE_2D, 0);
+	gpu_timer->begin_frame();
 
-	//reset vertex array to none:
-	glBindVertexArray(0);
+	//clear the color buffer:
+	gpu_timer->begin("clear");
+	glClearColor(bg_color.r / 255.0f, bg_color.g / 255.0f, bg_color.b / 255.0f, bg_color.a / 255.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	gpu_timer->end();
 
-	//reset current program to none:
-	glUseProgram(0);
-	
+	//don't use the depth test:
+	glDisable(GL_DEPTH_TEST);
+
+	//bring the buildings layer up to date with any placed/destroyed buildings, send new trail samples, and stream this frame's rects:
+	phase_start = Clock::now();
+	gpu_timer->begin("upload");
+	update_buildings_layer();
+	update_trail_layer();
+	draw_list->upload();
+	gpu_timer->end();
+	draw_ms.upload = ms_since(phase_start);
+
+	//sort + draw everything submitted above (draw_list sets program, texture, and blending):
+	phase_start = Clock::now();
+	gpu_timer->begin("draw");
+	draw_list->flush(court_to_clip);
+	gpu_timer->end();
+	draw_ms.flush = ms_since(phase_start);
+
+	gpu_timer->end_frame();
+
+	if (print_draw_stats) {
+		static auto last_print = std::chrono::high_resolution_clock::now();
+		auto now = std::chrono::high_resolution_clock::now();
+		if (now - last_print > std::chrono::seconds(1)) {
+			last_print = now;
+			DrawList::Stats const &stats = draw_list->stats;
+			std::cout << "draw: " << stats.submissions << " submissions, " << stats.draw_calls << " draw calls, "
+			          << stats.state_changes << " state changes, " << stats.vertices << " vertices, "
+			          << stats.uploads << " uploads (" << stats.upload_bytes << " bytes); "
+			          << "gl resources: " << GLResources::hits << " reused, " << GLResources::misses << " created" << std::endl;
+			std::cout << "gpu: " << gpu_timer->summary() << std::endl;
+		}
+	}
 
 	GL_ERRORS(); //PARANOIA: print errors just in case we did something wrong.
 
@@ -1,12 +1,20 @@
+#include "RectInstanceProgram.hpp"
+#include "TrailProgram.hpp"
 #include "ColorTextureProgram.hpp"
+#include "HudText.hpp"
+#include "PongSim.hpp"
+#include "DrawList.hpp"
+#include "GPUTimer.hpp"
+#include "GLResources.hpp"
 
 #include "Mode.hpp"
 #include "GL.hpp"
 
 #include <glm/glm.hpp>
 
+#include <memory>
+#include <string>
 #include <vector>
-#include <deque>
 
 /*
  * PongMode is a game mode that implements a single-player game of Pong.
@@ -14,139 +22,108 @@
 
 #define CURSOR_NORMAL -1
 
-#define BUILDING_SHOOTER 3
-#define BUILDING_WALL 1
-#define BUILDING_FARM 2
-
-#define INCOME_COOL 5.0f
-
-#define SHOOTER_COOL 5.0f
-#define WALL_COOL 15.0f
-#define FARM_COOL 10.0f
-
-#define SHOOTER_PRICE 2
-#define WALL_PRICE 1
-#define FARM_PRICE 5
-
 struct PongMode : Mode {
-	PongMode();
+	PongMode(); //(match seeded from the clock)
+	PongMode(uint32_t seed);
 	virtual ~PongMode();
 
 	//functions called by main loop:
 	virtual bool handle_event(SDL_Event const &, glm::uvec2 const &window_size) override;
 	virtual void update(float elapsed) override;
+	virtual void set_tick_fraction(float fraction) override;
 	virtual void draw(glm::uvec2 const &drawable_size) override;
 
 	//----- game state -----
 
-	glm::vec2 court_radius = glm::vec2(10.0f, 5.0f);
-	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
-	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
-	glm::vec2 building_radius = glm::vec2(0.25f, 0.25f);
-
-	float base_length = 5.0f;
-	float buffer_radius = 0.1f;
-
-	glm::vec2 left_paddle = glm::vec2(-court_radius.x + base_length, 0.0f);
-	glm::vec2 right_paddle = glm::vec2( court_radius.x - base_length, 0.0f);
-
-	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
-	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
-
-	uint32_t left_score = 0;
-	uint32_t right_score = 0;
+	//match state + rules (no GL in here, so it can also run headless):
+	PongSim sim;
 
-	uint32_t left_money = 0;
-	uint32_t right_money = 0;
-
-	int left_health = 100;
-	int right_health = 100;
-
-	float ai_offset = 0.0f;
-	float ai_offset_update = 0.0f;
+	//for drawing between ticks: moving things as they were before the last update, that update's step,
+	// and how far from there toward sim's current state to draw (see Mode::set_tick_fraction):
+	glm::vec2 previous_ball = sim.ball;
+	glm::vec2 previous_left_paddle = sim.left_paddle;
+	glm::vec2 previous_right_paddle = sim.right_paddle;
+	float last_elapsed = 0.0f;
+	float tick_fraction = 1.0f;
 
+	//building the player is about to place (or CURSOR_NORMAL):
 	int cursor_mode = CURSOR_NORMAL;
 	glm::vec2 cursor_pos;
-	std::vector<glm::vec2> buildings;
-	std::vector<int> building_types;
-	std::vector<float> building_cooldowns;
-
-	float income_cooldown = INCOME_COOL;
-
-	std::vector<glm::vec2> left_bullets;
-	std::vector<glm::vec2> right_bullets;
-	glm::vec2 bullet_radius = glm::vec2(0.1f, 0.1f);
-	float bullet_speed = 1.0f;
-
-	//AI
-	int next_purchase = BUILDING_SHOOTER;
-
-	//----- pretty gradient trails -----
-
-	float trail_length = 1.3f;
-	std::deque< glm::vec3 > ball_trail; //stores (x,y,age), oldest elements first
-
-	//Game logic helpers
-	bool overlaps(glm::vec2 c1, glm::vec2 r1, glm::vec2 c2, glm::vec2 r2){
-		//Collision detenction from starter code
-		glm::vec2 min = glm::max(c1 - r1, c2 - r2);
-		glm::vec2 max = glm::min(c1 + r1, c2 + r2);
-
-		return !(min.x > max.x || min.y > max.y);
-	}
-
-	bool overlaps_buildings(glm::vec2 c, glm::vec2 r){
-		for(size_t i=0;i<buildings.size();i++){
-			if(overlaps(c,r,buildings[i],building_radius)){
-				return true;
-			}
-		}
-		return false;
-	}
-
-	bool in_base(glm::vec2 c, glm::vec2 r){
-		glm::vec2 min = c-r;
-		glm::vec2 max = c+r;
-
-		return !(min.x < -1.0f * court_radius.x || min.y < -1.0f * court_radius.y
-		    || max.x > -court_radius.x + base_length - paddle_radius.x - buffer_radius || max.y > court_radius.y);
-	}
-
-	bool enough_money(){
-		switch(next_purchase){
-			case BUILDING_SHOOTER:
-				return right_money >= SHOOTER_PRICE;
-			case BUILDING_WALL:
-				return right_money >= WALL_PRICE;
-			case BUILDING_FARM:
-				return right_money >= FARM_PRICE;
-		}
-		return false;
-	}
 
 	//----- opengl assets / helpers ------
-
-	//draw functions will work on vectors of vertices, defined as follows:
-	struct Vertex {
-		Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
-			Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
-		glm::vec3 Position;
-		glm::u8vec4 Color;
-		glm::vec2 TexCoord;
+	//(shared through GLResources, so a restarted match reuses the previous PongMode's
+	// programs, buffers, and textures instead of building them again)
+
+	//Shader program that draws transformed, textured vertices tinted with vertex colors (used for HUD text):
+	std::shared_ptr< ColorTextureProgram const > color_texture_program;
+
+	//money + health + score readouts:
+	enum {
+		LABEL_LEFT_MONEY,
+		LABEL_RIGHT_MONEY,
+		LABEL_LEFT_HEALTH,
+		LABEL_RIGHT_HEALTH,
+		LABEL_LEFT_SCORE,
+		LABEL_RIGHT_SCORE,
+		LABEL_COUNT
 	};
-	static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "PongMode::Vertex should be packed");
-
-	//Shader program that draws transformed, vertices tinted with vertex colors:
-	ColorTextureProgram color_texture_program;
-
-	//Buffer used to hold vertex data during drawing:
-	GLuint vertex_buffer = 0;
-
-	//Vertex Array Object that maps buffer locations to color_texture_program attribute locations:
-	GLuint vertex_buffer_for_color_texture_program = 0;
-
-	//Solid white texture:
-	GLuint white_tex = 0;
+	std::shared_ptr< HudText > hud_text;
+
+	//Shader program that draws solid rectangles as instances of a unit quad:
+	std::shared_ptr< RectInstanceProgram const > rect_instance_program;
+
+	//Shader program that draws the ball's trail straight from sim.ball_trail's samples:
+	std::shared_ptr< TrailProgram const > trail_program;
+
+	//how streamed rectangles are uploaded each frame (set before creating a PongMode; see StreamBuffer):
+	static StreamBuffer::Method vertex_upload;
+
+	//everything is drawn through this (it also owns the rectangle stream + unit quad):
+	std::shared_ptr< DrawList > draw_list;
+
+	//print draw_list stats about once a second (toggled with F2):
+	bool print_draw_stats = false;
+
+	//CPU time (ms) the last draw() spent building + submitting the frame's draws, uploading, and flushing draw_list:
+	struct DrawTimes {
+		float submit = 0.0f;
+		float upload = 0.0f;
+		float flush = 0.0f;
+	} draw_ms;
+
+	//bytes the last draw() sent to the retained layers (buildings, trail);
+	// streamed bytes are in draw_list->stats.upload_bytes:
+	uint64_t layer_upload_bytes = 0;
+
+	//squares drawn along the ball's trail (0 draws no trail):
+	static uint32_t trail_steps;
+
+	//GPU time spent in draw()'s clear/upload/draw phases (read back a few frames late):
+	std::shared_ptr< GPUTimer > gpu_timer;
+	//if non-empty, every GPU timing is also logged here as CSV (set before creating a PongMode):
+	static std::string gpu_times_csv;
+
+	//----- retained layers -----
+	//(everything else is streamed through draw_list every frame)
+
+	//court walls never change: four wall shadows, then four walls:
+	// (shared by every PongMode with the same court size)
+	std::shared_ptr< GLBuffer > court_buffer;
+
+	//buildings: BUILDING_RECTS rectangles per Buildings slot (unused ones are zero-sized),
+	// patched with glBufferSubData only for slots in sim.buildings.changed_slots:
+	static constexpr uint32_t BUILDING_RECTS = 3;
+	GLuint buildings_buffer = 0;
+	std::vector< RectInstance > buildings_rects; //CPU copy of buildings_buffer
+	void update_buildings_layer();
+
+	//ball trail: a copy of sim.ball_trail's ring, read by trail_program through trail_tex
+	// (only samples added -- or moved -- since the last upload are sent):
+	GLBuffer trail_buffer;
+	GLTexture trail_tex;
+	GLVertexArray trail_vao; //(empty: trail_program has no vertex attributes)
+	uint32_t trail_uploaded = 0; //value of sim.ball_trail.written at the last upload
+	void update_trail_layer();
 
 	//matrix that maps from clip coordinates to court-space coordinates:
 	glm::mat3x2 clip_to_court = glm::mat3x2(1.0f);
@@ -0,0 +1,429 @@
+#include "PongSim.hpp"
+
+#include "aabb_overlap.hpp"
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <initializer_list>
+#include <limits>
+#include <utility>
+
+PongSim::PongSim(uint32_t seed) :
+	building_grid(-court_radius, court_radius, 4.0f * building_radius.x, building_radius),
+	//left AI buys in the same area the player is allowed to build in (see in_base), right AI in its mirror image:
+	left_placement(base_min(building_radius), base_max(building_radius), building_radius),
+	right_placement(
+		glm::vec2(-base_max(building_radius).x, base_min(building_radius).y),
+		glm::vec2(-base_min(building_radius).x, base_max(building_radius).y),
+		building_radius),
+	mt(seed) {
+	timers.schedule(INCOME_COOL, INCOME_COOL, INCOME_TIMER_ID, 0);
+
+
+	//set up trail as if ball has been here for 'forever':
+	ball_trail.reset(ball, float(time));
+}
+
+bool PongSim::place_building(int side, int type, glm::vec2 pos) {
+	uint32_t &money = (side == SIDE_LEFT ? left_money : right_money);
+	if (type != BUILDING_SHOOTER && type != BUILDING_WALL && type != BUILDING_FARM) return false;
+	if (money < price(type)) return false;
+
+	BuildingHandle handle = buildings.create(pos, (type == BUILDING_WALL ? BUILDING_WALL : side * type));
+	building_grid.insert(handle.slot, pos);
+	left_placement.add(pos);
+	right_placement.add(pos);
+
+	//walls never do anything on a timer, so only shooters + farms get one:
+	if (type == BUILDING_SHOOTER) {
+		timers.schedule(time + SHOOTER_COOL, SHOOTER_COOL, handle.slot, handle.generation);
+	} else if (type == BUILDING_FARM) {
+		timers.schedule(time + FARM_COOL, FARM_COOL, handle.slot, handle.generation);
+	}
+
+	money -= price(type);
+
+	if (side == SIDE_LEFT) ++left_built;
+	else ++right_built;
+
+	return true;
+}
+
+void PongSim::destroy_building(uint32_t i) {
+	if (buildings.dying[i]) return;
+	building_grid.remove(buildings.handles[i].slot, buildings.positions[i]);
+	left_placement.remove(buildings.positions[i]);
+	right_placement.remove(buildings.positions[i]);
+	buildings.destroy_at(i);
+}
+
+void PongSim::update_ai(int side, float elapsed) {
+	PaddleAI &ai = (side == SIDE_LEFT ? left_ai : right_ai);
+	glm::vec2 &paddle = (side == SIDE_LEFT ? left_paddle : right_paddle);
+
+	ai.offset_update -= elapsed;
+	if (ai.offset_update < elapsed) {
+		//update again in [0.5,1.0) seconds:
+		ai.offset_update = (mt() / float(mt.max())) * 0.5f + 0.5f;
+		ai.offset = (mt() / float(mt.max())) * 2.5f - 1.25f;
+	}
+	//chase the ball while it is in front of the paddle:
+	if((side == SIDE_RIGHT && ball.x < paddle.x) || (side == SIDE_LEFT && ball.x > paddle.x)){
+		if (paddle.y < ball.y + ai.offset) {
+			paddle.y = std::min(ball.y + ai.offset, paddle.y + 2.0f * elapsed);
+		} else {
+			paddle.y = std::max(ball.y + ai.offset, paddle.y - 2.0f * elapsed);
+		}
+	}
+	//Avoid ball if behind the paddle
+	else{
+		if (paddle.y < ball.y + ai.offset) {
+			paddle.y = std::min(ball.y + ai.offset, paddle.y - 2.0f * elapsed);
+		} else {
+			paddle.y = std::max(ball.y + ai.offset, paddle.y + 2.0f * elapsed);
+		}
+	}
+
+	//buy at a random free spot in the base (if the base is full, just keep saving up):
+	PlacementMap const &placement = (side == SIDE_LEFT ? left_placement : right_placement);
+	if (enough_money(side, ai.next_purchase) && !placement.full()) {
+		place_building(side, ai.next_purchase, placement.random_free(mt));
+		ai.next_purchase = int(mt() % 3) + 1;
+	}
+}
+
+//Swept box test: box moving from 'from' by 'delta' vs. a static box at 'center',
+// where 'reach' is the sum of both half-sizes (so this is a ray vs. expanded box test).
+//Computes the fraction of the move at which the boxes start ('*enter') and stop ('*exit') overlapping,
+// plus the normal of the face entered through; returns false if they never overlap during [0,1]:
+static bool sweep_box(glm::vec2 const &from, glm::vec2 const &delta, glm::vec2 const &center, glm::vec2 const &reach,
+	float *enter, float *exit, glm::vec2 *normal) {
+	float t_enter = -std::numeric_limits< float >::infinity();
+	float t_exit = std::numeric_limits< float >::infinity();
+	glm::vec2 n = glm::vec2(0.0f);
+	for (int axis = 0; axis < 2; ++axis) {
+		float lo = center[axis] - reach[axis] - from[axis];
+		float hi = center[axis] + reach[axis] - from[axis];
+		if (delta[axis] == 0.0f) {
+			//not moving on this axis, so must already be inside this slab:
+			if (lo > 0.0f || hi < 0.0f) return false;
+			continue;
+		}
+		float t0 = lo / delta[axis];
+		float t1 = hi / delta[axis];
+		if (t0 > t1) std::swap(t0, t1);
+		if (t0 > t_enter) {
+			t_enter = t0;
+			n = glm::vec2(0.0f);
+			n[axis] = (delta[axis] > 0.0f ? -1.0f : 1.0f);
+		}
+		t_exit = std::min(t_exit, t1);
+	}
+	if (t_enter > t_exit || t_exit < 0.0f || t_enter > 1.0f) return false;
+	*enter = t_enter;
+	*exit = t_exit;
+	*normal = n;
+	return true;
+}
+
+void PongSim::move_ball(float travel) {
+	//fraction of this tick's travel still to go:
+	float remaining = 1.0f;
+
+	for (uint32_t bounce = 0; bounce <= max_ball_bounces && remaining > 0.0f; ++bounce) {
+		glm::vec2 delta = remaining * travel * ball_velocity;
+
+		//---- find the first thing the ball hits along delta ----
+		enum HitKind { HitNone, HitPaddle, HitWall, HitCourt } hit = HitNone;
+		float hit_t = 1.0f;
+		glm::vec2 hit_normal = glm::vec2(0.0f);
+		glm::vec2 hit_center = glm::vec2(0.0f);
+		glm::vec2 hit_radius = glm::vec2(0.0f);
+
+		auto consider = [&](glm::vec2 const &center, glm::vec2 const &radius, HitKind kind) {
+			float enter, exit;
+			glm::vec2 normal;
+			if (!sweep_box(ball, delta, center, radius + ball_radius, &enter, &exit, &normal)) return;
+			//(ignore things already overlapped or being moved away from -- e.g., what was just bounced off)
+			if (enter < 0.0f || glm::dot(normal, delta) >= 0.0f) return;
+			if (enter < hit_t || hit == HitNone) {
+				hit = kind;
+				hit_t = enter;
+				hit_normal = normal;
+				hit_center = center;
+				hit_radius = radius;
+			}
+		};
+
+		consider(left_paddle, paddle_radius, HitPaddle);
+		consider(right_paddle, paddle_radius, HitPaddle);
+
+		//buildings near the swept path (wall buildings block the ball; others are just destroyed):
+		glm::vec2 path_min = glm::min(ball, ball + delta);
+		glm::vec2 path_max = glm::max(ball, ball + delta);
+		hits.clear();
+		building_grid.query(0.5f * (path_min + path_max), 0.5f * (path_max - path_min) + ball_radius, &hits);
+		for (uint32_t slot : hits) {
+			uint32_t i = buildings.slots[slot].index;
+			if (abs(buildings.types[i]) == BUILDING_WALL) {
+				consider(buildings.positions[i], building_radius, HitWall);
+			}
+		}
+
+		//court walls:
+		glm::vec2 limit = court_radius - ball_radius;
+		for (int axis = 0; axis < 2; ++axis) {
+			if (delta[axis] == 0.0f) continue;
+			float edge = (delta[axis] > 0.0f ? limit[axis] : -limit[axis]);
+			float t = (edge - ball[axis]) / delta[axis];
+			if (t >= 0.0f && t <= hit_t) {
+				hit = HitCourt;
+				hit_t = t;
+				hit_normal = glm::vec2(0.0f);
+				hit_normal[axis] = (delta[axis] > 0.0f ? -1.0f : 1.0f);
+			}
+		}
+
+		//---- destroy every building the ball sweeps over before (and including) the hit ----
+		for (uint32_t slot : hits) {
+			uint32_t i = buildings.slots[slot].index;
+			if (buildings.dying[i]) continue;
+			float enter, exit;
+			glm::vec2 normal;
+			if (sweep_box(ball, delta, buildings.positions[i], building_radius + ball_radius, &enter, &exit, &normal)
+			 && enter <= hit_t) {
+				destroy_building(i);
+			}
+		}
+
+		//---- move up to the hit ----
+		ball += hit_t * delta;
+		remaining *= (1.0f - hit_t);
+		if (hit == HitNone) break;
+
+		//---- bounce ----
+		if (hit_normal.x != 0.0f) {
+			ball_velocity.x = hit_normal.x * std::abs(ball_velocity.x);
+		} else {
+			ball_velocity.y = hit_normal.y * std::abs(ball_velocity.y);
+		}
+
+		if ((hit == HitPaddle || hit == HitWall) && hit_normal.x != 0.0f) {
+			//warp y velocity based on offset from paddle (or wall) center:
+			float vel = (ball.y - hit_center.y) / (hit_radius.y + ball_radius.y);
+			ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
+		}
+
+		if (hit == HitCourt && hit_normal.x < 0.0f) {
+			//hit the back of the right player's court:
+			right_health -= 10;
+			if(right_health < 0){
+				right_health = 0;
+			}
+		}
+		if (hit == HitCourt && hit_normal.x > 0.0f) {
+			//hit the back of the left player's court:
+			left_health -= 10;
+			if(left_health < 0){
+				left_health = 0;
+			}
+		}
+	}
+
+	//keep the ball in the court even if it ran out of bounces:
+	ball = glm::clamp(ball, -court_radius + ball_radius, court_radius - ball_radius);
+}
+
+void PongSim::update(float elapsed) {
+	PROFILE_SCOPE("sim.update");
+
+	time += elapsed;
+
+	//----- paddle update -----
+	{
+		PROFILE_SCOPE("sim.ai");
+		update_ai(SIDE_RIGHT, elapsed);
+		if (left_is_ai) update_ai(SIDE_LEFT, elapsed);
+
+		//clamp paddles to court:
+		right_paddle.y = std::max(right_paddle.y, -court_radius.y + paddle_radius.y);
+		right_paddle.y = std::min(right_paddle.y,  court_radius.y - paddle_radius.y);
+
+		left_paddle.y = std::max(left_paddle.y, -court_radius.y + paddle_radius.y);
+		left_paddle.y = std::min(left_paddle.y,  court_radius.y - paddle_radius.y);
+	}
+
+	//----- ball update -----
+	{
+		PROFILE_SCOPE("sim.ball");
+		//speed of ball increases every second:
+		float speed_multiplier = 4.0f * std::pow(2.0f, (left_score + right_score) / 4.0f);
+
+		//velocity cap, though:
+		// (the swept collision in move_ball() means this is a gameplay choice, not a tunneling fix)
+		speed_multiplier = std::min(speed_multiplier, ball_speed_cap);
+
+		//paddles may have moved into the ball since last tick; push it back out:
+		auto paddle_vs_ball = [this](glm::vec2 const &paddle) {
+			//compute area of overlap:
+			glm::vec2 min = glm::max(paddle - paddle_radius, ball - ball_radius);
+			glm::vec2 max = glm::min(paddle + paddle_radius, ball + ball_radius);
+
+			//if no overlap, no collision:
+			if (min.x > max.x || min.y > max.y) return;
+
+			if (max.x - min.x > max.y - min.y) {
+				//wider overlap in x => bounce in y direction:
+				if (ball.y > paddle.y) {
+					ball.y = paddle.y + paddle_radius.y + ball_radius.y;
+					ball_velocity.y = std::abs(ball_velocity.y);
+				} else {
+					ball.y = paddle.y - paddle_radius.y - ball_radius.y;
+					ball_velocity.y = -std::abs(ball_velocity.y);
+				}
+			} else {
+				//wider overlap in y => bounce in x direction:
+				if (ball.x > paddle.x) {
+					ball.x = paddle.x + paddle_radius.x + ball_radius.x;
+					ball_velocity.x = std::abs(ball_velocity.x);
+				} else {
+					ball.x = paddle.x - paddle_radius.x - ball_radius.x;
+					ball_velocity.x = -std::abs(ball_velocity.x);
+				}
+				//warp y velocity based on offset from paddle center:
+				float vel = (ball.y - paddle.y) / (paddle_radius.y + ball_radius.y);
+				ball_velocity.y = glm::mix(ball_velocity.y, vel, 0.75f);
+			}
+		};
+		paddle_vs_ball(left_paddle);
+		paddle_vs_ball(right_paddle);
+
+		//...then sweep the ball along its path, bouncing off anything it hits on the way:
+		move_ball(elapsed * speed_multiplier);
+	}
+
+	//---- timers (passive income + building cooldowns) ----
+	{
+		PROFILE_SCOPE("sim.timers");
+		TimerQueue::Timer timer;
+		while(uint32_t fires = timers.pop_due(time, &timer)){
+			//passive income:
+			if(timer.id == INCOME_TIMER_ID){
+				left_money += fires;
+				right_money += fires;
+				timers.reschedule(timer, fires);
+				continue;
+			}
+
+			//building timers outlive their buildings; drop them when they come up:
+			BuildingHandle handle;
+			handle.slot = timer.id;
+			handle.generation = timer.generation;
+			if(!buildings.valid(handle)) continue;
+			uint32_t i = buildings.index(handle);
+
+			switch(abs(buildings.types[i])){
+				case BUILDING_SHOOTER:
+					//spawn bullet(s)
+					for(uint32_t f = 0; f < fires; ++f){
+						glm::vec2 pos = buildings.positions[i];
+						if(buildings.types[i] == BUILDING_SHOOTER){
+							pos.x += building_radius.x + 2.0f * bullet_radius.x;
+							bullets.spawn(pos, SIDE_LEFT);
+						}
+						else{
+							pos.x -= building_radius.x + 2.0f * bullet_radius.x;
+							bullets.spawn(pos, SIDE_RIGHT);
+						}
+					}
+					break;
+				case BUILDING_FARM:
+					//Increase money
+					if(buildings.types[i] == BUILDING_FARM){
+						left_money += fires;
+					}
+					else{
+						right_money += fires;
+					}
+					break;
+			}
+			timers.reschedule(timer, fires);
+		}
+	}
+
+	//---- bullets (movement + collisions) ----
+	{
+		PROFILE_SCOPE("sim.bullets");
+		bullets.move(elapsed * bullet_speed);
+
+
+		//---- collision handling ----
+
+		//Bullet collisions
+
+		//find bullets touching either paddle (as two batched tests over the whole pool):
+		paddle_hit.assign(bullets.count, 0);
+		hits.resize(bullets.count);
+		for (glm::vec2 const &paddle : {left_paddle, right_paddle}) {
+			uint32_t n = aabb_overlap_batch(paddle, paddle_radius, bullets.x.data(), bullets.y.data(), bullets.count, bullet_radius, hits.data());
+			for (uint32_t h = 0; h < n; ++h) {
+				paddle_hit[hits[h]] = 1;
+			}
+		}
+
+		for(uint32_t i=0;i<bullets.count;i++){
+			glm::vec2 bullet = bullets.position(i);
+
+			//walls from above
+			if (bullets.owner[i] == SIDE_LEFT && bullet.x > court_radius.x - bullet_radius.x) {
+				bullets.kill(i);
+				right_health -= 5;
+				if(right_health < 0){
+					right_health = 0;
+				}
+				continue;
+			}
+			if (bullets.owner[i] == SIDE_RIGHT && bullet.x < -court_radius.x + bullet_radius.x) {
+				bullets.kill(i);
+				left_health -= 5;
+				if(left_health < 0){
+					left_health = 0;
+				}
+				continue;
+			}
+
+			//Paddles
+			if(paddle_hit[i]){
+				bullets.kill(i);
+				continue;
+			}
+
+			//Buildings
+			hits.clear();
+			building_grid.query(bullet, bullet_radius, &hits);
+			if(!hits.empty()){
+				//bullet stops at the first building it hits (walls survive):
+				uint32_t j = buildings.slots[hits[0]].index;
+				if(abs(buildings.types[j]) != BUILDING_WALL){
+					destroy_building(j);
+				}
+				bullets.kill(i);
+			}
+		}
+
+		//remove bullets that hit something this tick:
+		bullets.compact();
+
+		//remove buildings destroyed this tick:
+		buildings.flush();
+	}
+
+	//----- gradient trails -----
+	{
+		PROFILE_SCOPE("sim.trail");
+		//store fresh location (samples too old to draw are overwritten as the ring wraps):
+		ball_trail.push(ball, float(time));
+	}
+}
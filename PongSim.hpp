@@ -0,0 +1,190 @@
+#pragma once
+
+#include "Buildings.hpp"
+#include "Bullets.hpp"
+#include "SpatialGrid.hpp"
+#include "PlacementMap.hpp"
+#include "TimerQueue.hpp"
+#include "BallTrail.hpp"
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <random>
+
+/*
+ * PongSim holds the state and rules of one match of Pong of War.
+ * It does not touch OpenGL or SDL, so matches can be stepped without a window
+ *  (PongMode wraps it for play; headless.cpp fast-forwards it for balancing).
+ */
+
+#define BUILDING_SHOOTER 3
+#define BUILDING_WALL 1
+#define BUILDING_FARM 2
+
+#define INCOME_COOL 5.0f
+//timer id used for passive income (building timers use their handle's slot):
+#define INCOME_TIMER_ID 0xffffffffU
+
+#define SHOOTER_COOL 5.0f
+#define FARM_COOL 10.0f
+
+#define SHOOTER_PRICE 2
+#define WALL_PRICE 1
+#define FARM_PRICE 5
+
+//sides, as passed to place_building():
+#define SIDE_LEFT 1
+#define SIDE_RIGHT -1
+
+struct PongSim {
+	PongSim(uint32_t seed);
+
+	//advance the match by 'elapsed' seconds:
+	void update(float elapsed);
+
+	//match ends when either side runs out of health:
+	bool game_over() const { return left_health == 0 || right_health == 0; }
+
+	//----- game state -----
+
+	glm::vec2 court_radius = glm::vec2(10.0f, 5.0f);
+	glm::vec2 paddle_radius = glm::vec2(0.2f, 1.0f);
+	glm::vec2 ball_radius = glm::vec2(0.2f, 0.2f);
+	glm::vec2 building_radius = glm::vec2(0.25f, 0.25f);
+
+	float base_length = 5.0f;
+	float buffer_radius = 0.1f;
+
+	glm::vec2 left_paddle = glm::vec2(-court_radius.x + base_length, 0.0f);
+	glm::vec2 right_paddle = glm::vec2( court_radius.x - base_length, 0.0f);
+
+	glm::vec2 ball = glm::vec2(0.0f, 0.0f);
+	glm::vec2 ball_velocity = glm::vec2(-1.0f, 0.0f);
+
+	//cap on the ball's speed multiplier:
+	float ball_speed_cap = 10.0f;
+	//most bounces the ball resolves in one update() (any further travel that tick is dropped):
+	uint32_t max_ball_bounces = 8;
+
+	uint32_t left_score = 0;
+	uint32_t right_score = 0;
+
+	uint32_t left_money = 0;
+	uint32_t right_money = 0;
+
+	int left_health = 100;
+	int right_health = 100;
+
+	//building types are stored as +type for left-owned and -type for right-owned buildings
+	// (walls are always stored as +BUILDING_WALL, since their owner never matters);
+	//buildings destroyed during a tick are removed at the end of update():
+	Buildings buildings;
+
+	//index of building positions (by handle slot) for overlap queries;
+	// kept in sync by place_building() and destroy_building():
+	SpatialGrid building_grid;
+
+	//free building spots in each AI's purchase area (for any building, wherever placed);
+	// also kept in sync by place_building() and destroy_building():
+	PlacementMap left_placement;
+	PlacementMap right_placement;
+
+	//simulated time since the match started:
+	double time = 0.0;
+
+	//income, shooter and farm timers (walls have no timer):
+	TimerQueue timers;
+
+	//bullets from both sides (hits are removed at the end of update()):
+	Bullets bullets;
+	glm::vec2 bullet_radius = glm::vec2(0.1f, 0.1f);
+	float bullet_speed = 1.0f;
+
+	//number of buildings each side has placed over the match:
+	uint32_t left_built = 0;
+	uint32_t right_built = 0;
+
+	//----- AI -----
+
+	struct PaddleAI {
+		float offset = 0.0f;
+		float offset_update = 0.0f;
+		int next_purchase = BUILDING_SHOOTER;
+	};
+	PaddleAI right_ai;
+	PaddleAI left_ai;
+
+	//left paddle is normally driven by the player; set this to have the AI play it instead:
+	bool left_is_ai = false;
+
+	//all randomness in the match comes from here, so a seed reproduces a match:
+	std::mt19937 mt;
+
+	//----- pretty gradient trails -----
+
+	float trail_length = 1.3f;
+	//ball positions, stamped with (float) sim time:
+	BallTrail ball_trail = BallTrail(trail_length);
+
+	//----- game logic helpers -----
+
+	bool overlaps(glm::vec2 c1, glm::vec2 r1, glm::vec2 c2, glm::vec2 r2) const {
+		//Collision detenction from starter code
+		glm::vec2 min = glm::max(c1 - r1, c2 - r2);
+		glm::vec2 max = glm::min(c1 + r1, c2 + r2);
+
+		return !(min.x > max.x || min.y > max.y);
+	}
+
+	bool overlaps_buildings(glm::vec2 c, glm::vec2 r) const {
+		return building_grid.any(c, r);
+	}
+
+	//centers of the boxes (of half-size r) inside the left player's building area are in [base_min(r), base_max(r)]:
+	glm::vec2 base_min(glm::vec2 r) const {
+		return -court_radius + r;
+	}
+	glm::vec2 base_max(glm::vec2 r) const {
+		return glm::vec2(-court_radius.x + base_length - paddle_radius.x - buffer_radius, court_radius.y) - r;
+	}
+
+	//is the box inside the left player's building area?
+	bool in_base(glm::vec2 c, glm::vec2 r) const {
+		glm::vec2 min = base_min(r);
+		glm::vec2 max = base_max(r);
+
+		return !(c.x < min.x || c.y < min.y || c.x > max.x || c.y > max.y);
+	}
+
+	static uint32_t price(int type) {
+		switch(type){
+			case BUILDING_SHOOTER: return SHOOTER_PRICE;
+			case BUILDING_WALL: return WALL_PRICE;
+			case BUILDING_FARM: return FARM_PRICE;
+		}
+		return 0;
+	}
+
+	bool enough_money(int side, int type) const {
+		return (side == SIDE_LEFT ? left_money : right_money) >= price(type);
+	}
+
+	//buy a building of 'type' for 'side' at 'pos' if the side can afford it
+	// (placement validity is checked by the caller); returns true if placed:
+	bool place_building(int side, int type, glm::vec2 pos);
+
+	//remove building at dense index 'i' from the grid and mark it dying:
+	void destroy_building(uint32_t i);
+
+	//scratch space for grid queries + batched overlap tests:
+	std::vector< uint32_t > hits;
+	std::vector< uint8_t > paddle_hit;
+
+	//move the ball by travel * ball_velocity, bouncing off paddles, wall buildings, and the court
+	// (swept, so it can't tunnel through anything however far it goes in one tick):
+	void move_ball(float travel);
+
+	//paddle movement and purchasing for an AI-controlled side:
+	void update_ai(int side, float elapsed);
+};
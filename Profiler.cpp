@@ -0,0 +1,143 @@
+#include "Profiler.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+
+Profiler::Clock::time_point const Profiler::epoch = Profiler::Clock::now();
+uint64_t const Profiler::epoch_ticks = Profiler::now();
+
+namespace {
+
+//one per thread that has recorded anything; kept alive (by the registry) after the thread exits so its zones still export:
+struct ThreadLog {
+	std::vector< Profiler::Event > ring = std::vector< Profiler::Event >(Profiler::RING_SIZE);
+	std::atomic< uint64_t > next{0}; //total zones ever recorded (next slot is next % RING_SIZE)
+	uint32_t tid = 0;
+	std::string name;
+};
+
+struct Registry {
+	std::mutex mutex;
+	std::vector< std::shared_ptr< ThreadLog > > logs;
+};
+
+Registry &registry() {
+	//(function-local so it is constructed before any thread records)
+	static Registry registry;
+	return registry;
+}
+
+ThreadLog &thread_log() {
+	thread_local std::shared_ptr< ThreadLog > log;
+	if (!log) {
+		log = std::make_shared< ThreadLog >();
+		Registry &reg = registry();
+		std::lock_guard< std::mutex > lock(reg.mutex);
+		log->tid = uint32_t(reg.logs.size());
+		reg.logs.emplace_back(log);
+	}
+	return *log;
+}
+
+//write 's' as a JSON string:
+void write_json_string(std::ostream &out, char const *s) {
+	out << '"';
+	for (; *s; ++s) {
+		if (*s == '"' || *s == '\\') out << '\\';
+		if (uint8_t(*s) < 0x20) continue; //(control characters have no business in zone names)
+		out << *s;
+	}
+	out << '"';
+}
+
+} //namespace
+
+void Profiler::record(char const *name, uint64_t begin, uint64_t end) {
+	ThreadLog &log = thread_log();
+	uint64_t at = log.next.load(std::memory_order_relaxed);
+	Event &event = log.ring[at % RING_SIZE];
+	event.name = name;
+	event.begin = begin;
+	event.end = end;
+	log.next.store(at + 1, std::memory_order_release);
+}
+
+void Profiler::set_thread_name(std::string const &name) {
+	ThreadLog &log = thread_log();
+	std::lock_guard< std::mutex > lock(registry().mutex);
+	log.name = name;
+}
+
+bool Profiler::write_chrome_trace(std::string const &path) {
+	std::ofstream out(path);
+	if (!out) {
+		std::cerr << "WARNING: couldn't open '" << path << "' to write trace." << std::endl;
+		return false;
+	}
+
+	Registry &reg = registry();
+	std::lock_guard< std::mutex > lock(reg.mutex);
+
+	//ticks -> nanoseconds since startup:
+	double ns_per_tick = 1.0;
+	#if PROFILER_TSC
+	{ //calibrate the counter against the clock over the whole run so far:
+		uint64_t ticks = now() - epoch_ticks;
+		double ns = double(std::chrono::duration_cast< std::chrono::nanoseconds >(Clock::now() - epoch).count());
+		if (ticks > 0) ns_per_tick = ns / double(ticks);
+	}
+	#else
+	uint64_t const epoch_ns = epoch_ticks;
+	#endif
+
+	//timestamps are in microseconds (fractions are allowed):
+	auto us = [](uint64_t ns) {
+		return std::to_string(ns / 1000) + "." + std::to_string(1000 + ns % 1000).substr(1);
+	};
+	auto ticks_to_ns = [&](uint64_t ticks) -> uint64_t {
+		#if PROFILER_TSC
+		if (ticks < epoch_ticks) return 0; //(recorded before startup, i.e., during static initialization)
+		return uint64_t((ticks - epoch_ticks) * ns_per_tick);
+		#else
+		return ticks > epoch_ns ? ticks - epoch_ns : 0;
+		#endif
+	};
+
+	out << "{\"traceEvents\":[\n";
+	bool first = true;
+	auto comma = [&]() {
+		if (!first) out << ",\n";
+		first = false;
+	};
+
+	uint64_t events = 0;
+	for (auto const &log : reg.logs) {
+		if (!log->name.empty()) {
+			comma();
+			out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << log->tid << ",\"args\":{\"name\":";
+			write_json_string(out, log->name.c_str());
+			out << "}}";
+		}
+		uint64_t end = log->next.load(std::memory_order_acquire);
+		uint64_t begin = (end > RING_SIZE ? end - RING_SIZE : 0);
+		for (uint64_t i = begin; i < end; ++i) {
+			Event const &event = log->ring[i % RING_SIZE];
+			comma();
+			out << "{\"name\":";
+			write_json_string(out, event.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << log->tid
+			    << ",\"ts\":" << us(ticks_to_ns(event.begin)) << ",\"dur\":" << us(uint64_t((event.end - event.begin) * ns_per_tick)) << "}";
+			++events;
+		}
+	}
+	out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	if (!out) {
+		std::cerr << "WARNING: failed writing trace to '" << path << "'." << std::endl;
+		return false;
+	}
+	std::cout << "Wrote " << events << " profile zones to '" << path << "'." << std::endl;
+	return true;
+}
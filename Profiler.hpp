@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define PROFILER_TSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_TSC 1
+#else
+#define PROFILER_TSC 0
+#endif
+
+/*
+ * Profiler records timed CPU zones for inspection in a trace viewer
+ *  (chrome://tracing, Perfetto, or speedscope).
+ *
+ *   PROFILE_SCOPE("update"); //times from here to the end of the enclosing block
+ *
+ * Timestamps come from the CPU's time stamp counter where there is one (a
+ *  few cycles to read, vs. tens of nanoseconds for a steady_clock call) and
+ *  are converted to time at export, by comparing the counter's progress to
+ *  steady_clock's since startup; elsewhere, steady_clock is used directly.
+ *
+ * Each thread writes completed zones (name, begin, end) into its own
+ *  fixed-size ring, so recording takes no locks; when a ring is full the
+ *  oldest zones are overwritten. write_chrome_trace() dumps every thread's
+ *  ring as Chrome trace_event JSON. (Zones a thread records while the trace is
+ *  being written may be torn, so export when other profiled threads are idle.)
+ *
+ * Build with -DPONG_PROFILE=0 to compile PROFILE_SCOPE (and all recording) out entirely.
+ */
+
+#ifndef PONG_PROFILE
+#define PONG_PROFILE 1
+#endif
+
+struct Profiler {
+	typedef std::chrono::steady_clock Clock;
+
+	//zone names must outlive the profiler (string literals are ideal):
+	struct Event {
+		char const *name;
+		uint64_t begin; //in ticks of now()
+		uint64_t end;
+	};
+
+	//how many zones each thread keeps:
+	static constexpr uint32_t RING_SIZE = 1 << 16;
+
+	//times one zone (use PROFILE_SCOPE rather than naming one of these):
+	struct Zone {
+		Zone(char const *name_) : name(name_), begin(now()) { }
+		~Zone() { record(name, begin, now()); }
+		Zone(Zone const &) = delete;
+		Zone &operator=(Zone const &) = delete;
+		char const *name;
+		uint64_t begin;
+	};
+
+	//timestamp, in ticks (TSC cycles, or nanoseconds of Clock):
+	static uint64_t now() {
+	#if PROFILER_TSC
+		return __rdtsc();
+	#else
+		return uint64_t(std::chrono::duration_cast< std::chrono::nanoseconds >(Clock::now().time_since_epoch()).count());
+	#endif
+	}
+	static void record(char const *name, uint64_t begin, uint64_t end);
+
+	//label the calling thread in exported traces:
+	static void set_thread_name(std::string const &name);
+
+	//write all recorded zones as Chrome trace_event JSON; returns false on failure:
+	static bool write_chrome_trace(std::string const &path);
+
+	//startup time, for converting ticks to nanoseconds:
+	static Clock::time_point const epoch;
+	static uint64_t const epoch_ticks;
+};
+
+#define PROFILE_CONCAT2(A, B) A ## B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT2(A, B)
+
+#if PONG_PROFILE
+#define PROFILE_SCOPE(NAME) Profiler::Zone PROFILE_CONCAT(profile_zone_, __LINE__)(NAME)
+#else
+#define PROFILE_SCOPE(NAME) do { } while (0)
+#endif
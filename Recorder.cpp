@@ -0,0 +1,183 @@
+#include "Recorder.hpp"
+
+#include "load_save_png.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+	#define popen _popen
+	#define pclose _pclose
+	#define PIPE_MODE "wb"
+#else
+	#include <csignal>
+	#define PIPE_MODE "w"
+#endif
+
+bool Recorder::parse_format(std::string const &name, Format *format) {
+	assert(format);
+	if (name == "y4m") *format = Y4M;
+	else if (name == "raw") *format = Raw;
+	else if (name == "png") *format = PNG;
+	else return false;
+	return true;
+}
+
+char const *Recorder::extension(Format format) {
+	if (format == Y4M) return ".y4m";
+	if (format == Raw) return ".rgba";
+	return ""; //(PNG targets are a prefix)
+}
+
+//(more buffers and queue room than a screenshot needs, so a slow write doesn't immediately drop frames)
+Recorder::Recorder(Format format_, std::string const &target_, uint32_t fps_) : format(format_), target(target_), fps(fps_), capture(4, 8) {
+	assert(fps > 0);
+	if (format == PNG) return;
+
+	if (!target.empty() && target[0] == '|') {
+		#ifndef _WIN32
+		//if the encoder exits early, report a failed write instead of being killed by SIGPIPE:
+		std::signal(SIGPIPE, SIG_IGN);
+		#endif
+		out = popen(target.substr(1).c_str(), PIPE_MODE);
+		out_is_pipe = true;
+	} else {
+		out = std::fopen(target.c_str(), "wb");
+	}
+	if (!out) {
+		std::cerr << "ERROR: couldn't open '" << target << "' to record to." << std::endl;
+	}
+}
+
+Recorder::~Recorder() {
+	capture.finish();
+
+	if (out) {
+		if (out_is_pipe) pclose(out);
+		else std::fclose(out);
+		out = nullptr;
+	}
+
+	if (started) {
+		std::cout << "Recorded " << written << " frames (" << size.x << "x" << size.y << " at " << fps << " fps) to '" << target << "'; "
+		          << dropped << " of " << periods << " periods had no fresh frame and repeat the previous one"
+		          << (write_failed ? " (writing failed partway)" : "") << "." << std::endl;
+	}
+}
+
+bool Recorder::ok() const {
+	return format == PNG || out != nullptr;
+}
+
+void Recorder::frame(glm::uvec2 const &drawable_size) {
+	//pass earlier frames that have finished reading back to the writer:
+	capture.poll();
+
+	if (!ok() || write_failed) return;
+
+	auto now = std::chrono::steady_clock::now();
+	if (!started) {
+		started = true;
+		start = now;
+		size = drawable_size;
+	}
+
+	//period this frame falls in:
+	uint64_t period = uint64_t(std::chrono::duration< double >(now - start).count() * fps);
+	if (period < next_period) return; //already have a frame for this period
+
+	//this frame covers its own period plus any that went by without a frame:
+	uint64_t missed = period - next_period;
+	next_period = period + 1;
+	periods = next_period;
+
+	uint64_t repeat = 1 + missed + owed;
+	bool captured = false;
+	if (drawable_size == size) {
+		captured = capture.capture(size, GL_BACK, [this, repeat](FrameCapture::Frame &frame) {
+			write(frame, repeat);
+		});
+	}
+	if (captured) {
+		dropped += missed;
+		owed = 0;
+	} else {
+		dropped += 1 + missed;
+		owed = repeat;
+	}
+}
+
+void Recorder::write_bytes(void const *data, size_t bytes) {
+	if (write_failed) return;
+	if (std::fwrite(data, 1, bytes, out) != bytes) {
+		std::cerr << "ERROR: writing recording to '" << target << "' failed; stopping." << std::endl;
+		write_failed = true;
+	}
+}
+
+void Recorder::write(FrameCapture::Frame &frame, uint64_t repeat) {
+	if (write_failed) return;
+	FrameCapture::force_opaque(frame.pixels.data(), frame.pixels.size());
+	uint32_t w = frame.size.x, h = frame.size.y;
+
+	if (format == PNG) {
+		char index[16];
+		std::snprintf(index, sizeof(index), "-%06u", uint32_t(png_index++));
+		save_png(target + index + ".png", frame.size, frame.pixels.data(), LowerLeftOrigin);
+		written += 1;
+		return;
+	}
+
+	if (format == Raw) {
+		//flip to top row first:
+		scratch.resize(size_t(w) * h * 4);
+		for (uint32_t y = 0; y < h; ++y) {
+			std::memcpy(&scratch[size_t(y) * w * 4], &frame.pixels[size_t(h - 1 - y) * w], size_t(w) * 4);
+		}
+	} else { assert(format == Y4M);
+		if (!header_written) {
+			char header[128];
+			int length = std::snprintf(header, sizeof(header), "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XCOLORRANGE=LIMITED\n", w, h, fps);
+			write_bytes(header, size_t(length));
+			header_written = true;
+		}
+		//BT.601, limited range (hence XCOLORRANGE=LIMITED): Y for every pixel, then U and V for every 2x2 block, top row first:
+		uint32_t cw = (w + 1) / 2, ch = (h + 1) / 2;
+		static char const frame_tag[] = "FRAME\n";
+		size_t tag = sizeof(frame_tag) - 1;
+		scratch.resize(tag + size_t(w) * h + 2 * size_t(cw) * ch);
+		std::memcpy(scratch.data(), frame_tag, tag);
+		uint8_t *Y = scratch.data() + tag;
+		uint8_t *U = Y + size_t(w) * h;
+		uint8_t *V = U + size_t(cw) * ch;
+		auto at = [&](uint32_t x, uint32_t y) -> glm::u8vec4 const & {
+			return frame.pixels[size_t(h - 1 - std::min(y, h - 1)) * w + std::min(x, w - 1)];
+		};
+		for (uint32_t y = 0; y < h; ++y) {
+			for (uint32_t x = 0; x < w; ++x) {
+				glm::u8vec4 const &px = at(x, y);
+				Y[size_t(y) * w + x] = uint8_t(((66 * px.r + 129 * px.g + 25 * px.b + 128) >> 8) + 16);
+			}
+		}
+		for (uint32_t cy = 0; cy < ch; ++cy) {
+			for (uint32_t cx = 0; cx < cw; ++cx) {
+				int r = 0, g = 0, b = 0;
+				for (uint32_t s = 0; s < 4; ++s) {
+					glm::u8vec4 const &px = at(2 * cx + (s & 1), 2 * cy + (s >> 1));
+					r += px.r; g += px.g; b += px.b;
+				}
+				r = (r + 2) / 4; g = (g + 2) / 4; b = (b + 2) / 4;
+				U[size_t(cy) * cw + cx] = uint8_t(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+				V[size_t(cy) * cw + cx] = uint8_t(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+			}
+		}
+	}
+
+	for (uint64_t i = 0; i < repeat; ++i) {
+		write_bytes(scratch.data(), scratch.size());
+		if (write_failed) return;
+		written += 1;
+	}
+}
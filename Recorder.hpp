@@ -0,0 +1,88 @@
+#pragma once
+
+#include "FrameCapture.hpp"
+
+#include <glm/glm.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+ * Recorder captures presented frames at a fixed rate and writes them out on
+ *  FrameCapture's background thread, in one of three formats:
+ *
+ *   Y4M -- YUV4MPEG2 (4:2:0, BT.601 limited range), which most encoders read directly;
+ *   Raw -- bare RGBA frames, top row first
+ *          (e.g. ffmpeg -f rawvideo -pix_fmt rgba -s WxH -framerate FPS -i -);
+ *   PNG -- a numbered sequence: target + "-000000.png", ...
+ *
+ * For Y4M and Raw, a target starting with '|' is run as a command and the
+ *  stream is piped to its standard input (e.g. "|ffmpeg -i - match.mp4").
+ *
+ * Call frame() once per presented frame, after drawing and before the swap
+ *  (it also moves finished readbacks along to the writer).
+ *  Frames are taken on a fixed clock of 'fps' periods per second. If a
+ *  period gets no fresh frame -- the game ran slower than 'fps', or the
+ *  readback/writer pipeline was full -- it counts as dropped, and the next
+ *  captured frame is written again in its place. So Y4M/Raw streams keep
+ *  real-time length. (PNG sequences write each captured frame once.)
+ *
+ * The recorded size is the drawable size when recording starts; frames at
+ *  other sizes (after a window resize) are dropped.
+ */
+
+struct Recorder {
+	enum Format {
+		Y4M,
+		Raw,
+		PNG,
+	};
+	//"y4m", "raw", or "png":
+	static bool parse_format(std::string const &name, Format *format);
+	static char const *extension(Format format);
+
+	Recorder(Format format, std::string const &target, uint32_t fps);
+	~Recorder(); //finishes writing everything captured so far
+
+	Recorder(Recorder const &) = delete;
+	Recorder &operator=(Recorder const &) = delete;
+
+	//false if the target couldn't be opened (nothing will be recorded):
+	bool ok() const;
+
+	void frame(glm::uvec2 const &drawable_size);
+
+	//----- stats -----
+	uint64_t periods = 0; //fixed-rate periods elapsed
+	uint64_t dropped = 0; //periods without a fresh frame
+	std::atomic< uint64_t > written{0}; //frames written (including repeats)
+	std::atomic< bool > write_failed{false};
+
+	//----- internals -----
+	Format format;
+	std::string target;
+	uint32_t fps;
+
+	FILE *out = nullptr; //(Y4M and Raw)
+	bool out_is_pipe = false;
+
+	std::chrono::steady_clock::time_point start;
+	bool started = false;
+	glm::uvec2 size = glm::uvec2(0);
+	uint64_t next_period = 0; //first period not yet covered by a captured frame
+	uint64_t owed = 0; //dropped periods the next captured frame should also cover
+
+	//only touched on the writer thread:
+	bool header_written = false;
+	uint64_t png_index = 0;
+	std::vector< uint8_t > scratch;
+	void write(FrameCapture::Frame &frame, uint64_t repeat);
+	void write_bytes(void const *data, size_t bytes);
+
+	//last, so that it finishes (running write()) before anything above is destroyed:
+	FrameCapture capture;
+};
@@ -0,0 +1,43 @@
+#include "RectInstanceProgram.hpp"
+
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+RectInstanceProgram::RectInstanceProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"in vec2 Corner;\n"
+		"in vec2 Center;\n"
+		"in vec2 Radius;\n"
+		"in vec4 Color;\n"
+		"out vec4 color;\n"
+		"void main() {\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(Center + Corner * Radius, 0.0, 1.0);\n"
+		"	color = Color;\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of vertex attributes:
+	Corner_vec2 = glGetAttribLocation(program, "Corner");
+	Center_vec2 = glGetAttribLocation(program, "Center");
+	Radius_vec2 = glGetAttribLocation(program, "Radius");
+	Color_vec4 = glGetAttribLocation(program, "Color");
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+}
+
+RectInstanceProgram::~RectInstanceProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
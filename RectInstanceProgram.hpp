@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <glm/glm.hpp>
+
+//Shader program that draws solid-colored, axis-aligned rectangles as instances of a unit quad:
+struct RectInstanceProgram {
+	RectInstanceProgram();
+	~RectInstanceProgram();
+
+	GLuint program = 0;
+
+	//Attribute (per-vertex variable) locations:
+	GLuint Corner_vec2 = -1U; //corner of the unit quad, in [-1,1]^2
+
+	//Attribute (per-instance variable) locations:
+	GLuint Center_vec2 = -1U;
+	GLuint Radius_vec2 = -1U;
+	GLuint Color_vec4 = -1U;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+};
+
+//per-instance data, as streamed to Center_vec2, Radius_vec2, Color_vec4:
+struct RectInstance {
+	RectInstance(glm::vec2 const &Center_, glm::vec2 const &Radius_, glm::u8vec4 const &Color_) :
+		Center(Center_), Radius(Radius_), Color(Color_) { }
+	glm::vec2 Center;
+	glm::vec2 Radius;
+	glm::u8vec4 Color;
+};
+static_assert(sizeof(RectInstance) == 4*2 + 4*2 + 1*4, "RectInstance should be packed");
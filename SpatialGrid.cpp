@@ -0,0 +1,94 @@
+#include "SpatialGrid.hpp"
+
+#include "aabb_overlap.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+SpatialGrid::SpatialGrid(glm::vec2 const &min_, glm::vec2 const &max_, float cell_size_, glm::vec2 const &item_radius_)
+	: min(min_), cell_size(cell_size_), item_radius(item_radius_) {
+	assert(cell_size > 0.0f);
+	count.x = std::max(1, int32_t(std::ceil((max_.x - min_.x) / cell_size)));
+	count.y = std::max(1, int32_t(std::ceil((max_.y - min_.y) / cell_size)));
+	cells.resize(count.x * count.y);
+}
+
+glm::ivec2 SpatialGrid::cell_of(glm::vec2 const &position) const {
+	glm::ivec2 at;
+	at.x = int32_t(std::floor((position.x - min.x) / cell_size));
+	at.y = int32_t(std::floor((position.y - min.y) / cell_size));
+	at.x = std::max(0, std::min(count.x - 1, at.x));
+	at.y = std::max(0, std::min(count.y - 1, at.y));
+	return at;
+}
+
+void SpatialGrid::insert(uint32_t id, glm::vec2 const &position) {
+	Cell &c = cell(cell_of(position));
+	c.x.emplace_back(position.x);
+	c.y.emplace_back(position.y);
+	c.ids.emplace_back(id);
+}
+
+void SpatialGrid::remove(uint32_t id, glm::vec2 const &position) {
+	Cell &c = cell(cell_of(position));
+	for (size_t i = 0; i < c.ids.size(); ++i) {
+		if (c.ids[i] != id) continue;
+		//swap-and-pop:
+		c.x[i] = c.x.back(); c.x.pop_back();
+		c.y[i] = c.y.back(); c.y.pop_back();
+		c.ids[i] = c.ids.back(); c.ids.pop_back();
+		return;
+	}
+	assert(0 && "removed id that wasn't in the grid");
+}
+
+void SpatialGrid::clear() {
+	for (auto &c : cells) {
+		c.x.clear();
+		c.y.clear();
+		c.ids.clear();
+	}
+}
+
+void SpatialGrid::query(glm::vec2 const &center, glm::vec2 const &radius, std::vector< uint32_t > *hits) const {
+	assert(hits);
+	//any item whose center is within (radius + item_radius) of the query center may overlap:
+	glm::vec2 reach = radius + item_radius;
+	glm::ivec2 lo = cell_of(center - reach);
+	glm::ivec2 hi = cell_of(center + reach);
+	for (int32_t cy = lo.y; cy <= hi.y; ++cy) {
+		for (int32_t cx = lo.x; cx <= hi.x; ++cx) {
+			Cell const &c = cell(glm::ivec2(cx, cy));
+			if (c.ids.empty()) continue;
+			//test the whole cell in one batch, writing in-cell indices to the end of hits:
+			size_t base = hits->size();
+			hits->resize(base + c.ids.size());
+			uint32_t n = aabb_overlap_batch(center, radius, c.x.data(), c.y.data(), uint32_t(c.ids.size()), item_radius, hits->data() + base);
+			//...then convert them to ids:
+			for (size_t i = base; i < base + n; ++i) {
+				(*hits)[i] = c.ids[(*hits)[i]];
+			}
+			hits->resize(base + n);
+		}
+	}
+}
+
+bool SpatialGrid::any(glm::vec2 const &center, glm::vec2 const &radius) const {
+	glm::vec2 reach = radius + item_radius;
+	glm::ivec2 lo = cell_of(center - reach);
+	glm::ivec2 hi = cell_of(center + reach);
+	uint32_t buffer[64];
+	for (int32_t cy = lo.y; cy <= hi.y; ++cy) {
+		for (int32_t cx = lo.x; cx <= hi.x; ++cx) {
+			Cell const &c = cell(glm::ivec2(cx, cy));
+			for (size_t begin = 0; begin < c.ids.size(); begin += 64) {
+				uint32_t count = uint32_t(std::min< size_t >(64, c.ids.size() - begin));
+				if (aabb_overlap_batch(center, radius, c.x.data() + begin, c.y.data() + begin, count, item_radius, buffer)) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * SpatialGrid is a uniform grid over a rectangular area, used to find which
+ *  (static, equal-sized) boxes overlap a query box without testing all of them.
+ *
+ * Each item is stored in the single cell containing its center; queries grow
+ *  the searched cell range by the item radius to account for this.
+ * Items are identified by a caller-chosen id (PongSim uses building handle slots).
+ */
+
+struct SpatialGrid {
+	//cover [min,max] with square cells of side 'cell_size'; all items are boxes of half-size 'item_radius':
+	SpatialGrid(glm::vec2 const &min, glm::vec2 const &max, float cell_size, glm::vec2 const &item_radius);
+
+	void insert(uint32_t id, glm::vec2 const &position);
+	//'position' must be the same as was passed to insert():
+	void remove(uint32_t id, glm::vec2 const &position);
+	void clear();
+
+	//append ids of all items overlapping the box (center, radius) to *hits:
+	// (overlap test matches PongSim::overlaps -- touching counts)
+	void query(glm::vec2 const &center, glm::vec2 const &radius, std::vector< uint32_t > *hits) const;
+	//does any item overlap the box?
+	bool any(glm::vec2 const &center, glm::vec2 const &radius) const;
+
+	//----- internals -----
+	//items in each cell are stored as parallel arrays (so they can be tested in batches):
+	struct Cell {
+		std::vector< float > x;
+		std::vector< float > y;
+		std::vector< uint32_t > ids;
+	};
+
+	glm::vec2 min;
+	float cell_size;
+	glm::vec2 item_radius;
+	glm::ivec2 count; //number of cells in x and y
+	std::vector< Cell > cells; //count.x * count.y cells, row-major
+
+	//cell coordinate containing a point (clamped to the grid):
+	glm::ivec2 cell_of(glm::vec2 const &position) const;
+	Cell &cell(glm::ivec2 const &at) { return cells[at.y * count.x + at.x]; }
+	Cell const &cell(glm::ivec2 const &at) const { return cells[at.y * count.x + at.x]; }
+};
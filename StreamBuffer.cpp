@@ -0,0 +1,145 @@
+#include "StreamBuffer.hpp"
+
+#include "gl_errors.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+static size_t round_up(size_t bytes, size_t multiple) {
+	return (bytes + multiple - 1) / multiple * multiple;
+}
+
+StreamBuffer::StreamBuffer(Method method_, size_t alignment_, size_t region_size_, uint32_t regions)
+	: method(method_), alignment(alignment_) {
+	assert(alignment > 0);
+	assert(regions > 0);
+
+	glGenBuffers(1, &buffer);
+
+	region_size = round_up(region_size_, alignment);
+	fences.assign(regions, nullptr);
+	if (method == Ring) allocate();
+
+	GL_ERRORS();
+}
+
+StreamBuffer::~StreamBuffer() {
+	assert(!mapped);
+	for (auto &fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	glDeleteBuffers(1, &buffer);
+	buffer = 0;
+}
+
+void StreamBuffer::allocate() {
+	//fresh storage, so nothing is pending on any region:
+	for (auto &fence : fences) {
+		if (fence) glDeleteSync(fence);
+		fence = nullptr;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	glBufferData(GL_ARRAY_BUFFER, region_size * fences.size(), nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void StreamBuffer::wait(uint32_t r) {
+	if (!fences[r]) return;
+
+	GLenum result = glClientWaitSync(fences[r], 0, 0);
+	if (result == GL_TIMEOUT_EXPIRED) {
+		//actually have to block (flushing, in case the fence hasn't been submitted yet):
+		waits += 1;
+		do {
+			result = glClientWaitSync(fences[r], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+		} while (result == GL_TIMEOUT_EXPIRED);
+	}
+	if (result == GL_WAIT_FAILED) {
+		std::cerr << "WARNING: glClientWaitSync failed on stream buffer region; waiting with glFinish()." << std::endl;
+		glFinish();
+	}
+	glDeleteSync(fences[r]);
+	fences[r] = nullptr;
+}
+
+void *StreamBuffer::map(size_t bytes) {
+	assert(!mapped);
+	mapped = true;
+
+	if (method == Orphan) {
+		if (staging.size() < bytes) staging.resize(bytes);
+		mapped_at = 0;
+		return staging.data();
+	}
+
+	bytes = round_up(bytes, alignment);
+	if (head + bytes > region_size) {
+		if (head == 0 || bytes > region_size) {
+			//frame's data doesn't fit in a region at all; grow the ring:
+			region_size = round_up(std::max(bytes + head, 2 * region_size), alignment);
+			allocate();
+			grows += 1;
+		} else {
+			//frame has overrun its region; spill into the next one
+			// (draws from earlier ranges have been issued, so the region can be fenced now):
+			assert(!fences[region]);
+			fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			region = (region + 1) % uint32_t(fences.size());
+			head = 0;
+		}
+	}
+	if (head == 0) wait(region);
+
+	mapped_at = region * region_size + head;
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	void *data = glMapBufferRange(GL_ARRAY_BUFFER, mapped_at, bytes,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (!data) {
+		GL_ERRORS();
+		throw std::runtime_error("StreamBuffer: glMapBufferRange failed.");
+	}
+	return data;
+}
+
+GLintptr StreamBuffer::unmap(size_t used) {
+	assert(mapped);
+	mapped = false;
+	bytes_uploaded += used;
+
+	if (method == Orphan) {
+		assert(used <= staging.size());
+		glBindBuffer(GL_ARRAY_BUFFER, buffer);
+		glBufferData(GL_ARRAY_BUFFER, used, staging.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		return 0;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	if (glUnmapBuffer(GL_ARRAY_BUFFER) != GL_TRUE) {
+		//(storage contents were lost, e.g. on a display mode change; the next frame re-writes them anyway)
+		std::cerr << "WARNING: stream buffer contents were corrupted while mapped." << std::endl;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	GLintptr offset = GLintptr(mapped_at);
+	head += round_up(used, alignment);
+	return offset;
+}
+
+void StreamBuffer::end_frame() {
+	assert(!mapped);
+	if (method == Orphan) return;
+
+	//fence the region this frame last wrote into:
+	if (head != 0) {
+		assert(!fences[region]);
+		fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+	region = (region + 1) % uint32_t(fences.size());
+	head = 0;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * StreamBuffer is a vertex buffer for data that is rewritten every frame.
+ *
+ * With StreamBuffer::Ring, the buffer is split into one region per frame in
+ *  flight. Each frame writes into its own region through an unsynchronized
+ *  glMapBufferRange() (so the driver never stalls or reallocates), and
+ *  end_frame() drops a fence after the frame's draws; a region is only
+ *  reused once the GPU has passed its fence.
+ *
+ * StreamBuffer::Orphan is the old path: data is written into a CPU-side
+ *  staging array and each unmap() re-specifies the whole buffer with
+ *  glBufferData(..., GL_STREAM_DRAW).
+ *
+ * Usage, per frame:
+ *   void *data = stream.map(max_bytes); //write up to max_bytes here
+ *   GLintptr offset = stream.unmap(used_bytes); //data is at 'offset' in stream.buffer
+ *   ... draw from stream.buffer ...
+ *   (more map/unmap/draw as needed; draw from each range before mapping the next)
+ *   stream.end_frame();
+ */
+
+struct StreamBuffer {
+	enum Method {
+		Orphan,
+		Ring,
+	};
+
+	//'alignment' is the size of one element (e.g., a vertex), so every offset returned
+	// by unmap() is a whole number of elements into the buffer:
+	StreamBuffer(Method method, size_t alignment, size_t region_size = 1 << 20, uint32_t regions = 3);
+	~StreamBuffer();
+
+	StreamBuffer(StreamBuffer const &) = delete;
+	StreamBuffer &operator=(StreamBuffer const &) = delete;
+
+	//get 'bytes' of writable memory for this frame (grows the buffer if needed):
+	void *map(size_t bytes);
+
+	//finish writing (only the first 'used' bytes count); returns the offset of the data in 'buffer':
+	GLintptr unmap(size_t used);
+
+	//call after all draws reading this frame's data have been issued:
+	void end_frame();
+
+	GLuint buffer = 0; //GL_ARRAY_BUFFER
+
+	Method method;
+	size_t alignment;
+
+	//----- stats -----
+	uint64_t bytes_uploaded = 0; //total bytes passed to unmap()
+	uint64_t waits = 0; //times map() had to block on the GPU
+	uint64_t grows = 0; //times the ring was reallocated to fit a frame
+
+	//----- internals -----
+	size_t region_size; //bytes per region (multiple of alignment)
+	uint32_t region = 0; //region the current frame writes into
+	size_t head = 0; //next free byte in the current region
+	std::vector< GLsync > fences; //per region, set by end_frame(); 0 if the region is free
+	bool mapped = false;
+	size_t mapped_at = 0; //offset of the current mapping in the buffer
+	std::vector< uint8_t > staging; //Orphan: CPU-side copy written by map()
+
+	void allocate(); //(re-)create ring storage, region_size * fences.size() bytes
+	void wait(uint32_t region); //block until the GPU is done with 'region'
+};
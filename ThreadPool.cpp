@@ -0,0 +1,102 @@
+#include "ThreadPool.hpp"
+
+#include "Profiler.hpp"
+
+#include <cassert>
+#include <string>
+
+ThreadPool::ThreadPool(uint32_t threads) {
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+
+	for (uint32_t i = 0; i < threads; ++i) {
+		queues.emplace_back(new Queue);
+	}
+	for (uint32_t i = 0; i < threads; ++i) {
+		workers.emplace_back(&ThreadPool::work, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		stopping = true;
+	}
+	work_available.notify_all();
+	for (auto &worker : workers) {
+		worker.join();
+	}
+}
+
+void ThreadPool::submit(std::function< void() > const &task) {
+	uint32_t q;
+	{
+		std::unique_lock< std::mutex > lock(mutex);
+		pending += 1;
+		queued += 1;
+		q = next_queue;
+		next_queue = (next_queue + 1) % uint32_t(queues.size());
+	}
+	{
+		std::unique_lock< std::mutex > lock(queues[q]->mutex);
+		queues[q]->tasks.emplace_back(task);
+	}
+	work_available.notify_one();
+}
+
+void ThreadPool::wait() {
+	std::unique_lock< std::mutex > lock(mutex);
+	all_done.wait(lock, [this](){ return pending == 0; });
+}
+
+bool ThreadPool::take(uint32_t worker, std::function< void() > *task) {
+	assert(task);
+	//newest task from own queue:
+	{
+		Queue &own = *queues[worker];
+		std::unique_lock< std::mutex > lock(own.mutex);
+		if (!own.tasks.empty()) {
+			*task = std::move(own.tasks.back());
+			own.tasks.pop_back();
+			return true;
+		}
+	}
+	//...or oldest task from someone else's:
+	for (uint32_t i = 1; i < queues.size(); ++i) {
+		Queue &other = *queues[(worker + i) % queues.size()];
+		std::unique_lock< std::mutex > lock(other.mutex);
+		if (!other.tasks.empty()) {
+			*task = std::move(other.tasks.front());
+			other.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+void ThreadPool::work(uint32_t worker) {
+	Profiler::set_thread_name("worker " + std::to_string(worker));
+	std::function< void() > task;
+	while (true) {
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			work_available.wait(lock, [this](){ return stopping || queued > 0; });
+			if (queued == 0) return; //stopping and out of work
+			//claim one task (so sleeping workers aren't woken for work that is already spoken for):
+			queued -= 1;
+		}
+
+		//a claimed task is always in some queue, though another worker may be mid-push or mid-take:
+		while (!take(worker, &task)) {
+			std::this_thread::yield();
+		}
+		task();
+		task = nullptr;
+
+		{
+			std::unique_lock< std::mutex > lock(mutex);
+			pending -= 1;
+			if (pending == 0) all_done.notify_all();
+		}
+	}
+}
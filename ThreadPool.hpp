@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cstdint>
+
+/*
+ * ThreadPool is a fixed set of worker threads with one task deque per worker.
+ *
+ * submit() deals tasks out round-robin; each worker runs tasks from the back
+ *  of its own deque and, once that is empty, steals from the front of the
+ *  others' deques -- so workers that draw short tasks (e.g. quick matches)
+ *  keep busy taking work from workers stuck on long ones.
+ */
+
+struct ThreadPool {
+	//threads == 0 means one per hardware thread:
+	ThreadPool(uint32_t threads = 0);
+	~ThreadPool();
+
+	ThreadPool(ThreadPool const &) = delete;
+	ThreadPool &operator=(ThreadPool const &) = delete;
+
+	uint32_t size() const { return uint32_t(workers.size()); }
+
+	void submit(std::function< void() > const &task);
+
+	//block until every submitted task has finished:
+	void wait();
+
+	//----- internals -----
+	struct Queue {
+		std::mutex mutex;
+		std::deque< std::function< void() > > tasks;
+	};
+	std::vector< std::unique_ptr< Queue > > queues; //one per worker
+	std::vector< std::thread > workers;
+
+	std::mutex mutex; //guards everything below
+	std::condition_variable work_available;
+	std::condition_variable all_done;
+	uint64_t pending = 0; //submitted but not yet finished
+	uint64_t queued = 0; //submitted but not yet started
+	uint32_t next_queue = 0;
+	bool stopping = false;
+
+	bool take(uint32_t worker, std::function< void() > *task);
+	void work(uint32_t worker);
+};
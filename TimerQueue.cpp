@@ -0,0 +1,46 @@
+#include "TimerQueue.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+//std heap functions build max-heaps, so order by "fires later":
+static bool fires_later(TimerQueue::Timer const &a, TimerQueue::Timer const &b) {
+	if (a.time != b.time) return a.time > b.time;
+	return a.order > b.order;
+}
+
+void TimerQueue::push(Timer const &timer) {
+	heap.emplace_back(timer);
+	heap.back().order = next_order++;
+	std::push_heap(heap.begin(), heap.end(), fires_later);
+}
+
+void TimerQueue::schedule(double time, float period, uint32_t id, uint32_t generation) {
+	assert(period > 0.0f);
+	Timer timer;
+	timer.time = time;
+	timer.period = period;
+	timer.id = id;
+	timer.generation = generation;
+	push(timer);
+}
+
+uint32_t TimerQueue::pop_due(double now, Timer *timer) {
+	assert(timer);
+	if (heap.empty() || !(heap.front().time < now)) return 0;
+
+	std::pop_heap(heap.begin(), heap.end(), fires_later);
+	*timer = heap.back();
+	heap.pop_back();
+
+	//fires once for every period start strictly before 'now':
+	double fires = std::ceil((now - timer->time) / timer->period);
+	return std::max(1u, uint32_t(fires));
+}
+
+void TimerQueue::reschedule(Timer const &timer, uint32_t fires) {
+	Timer next = timer;
+	next.time = timer.time + double(fires) * timer.period;
+	push(next);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * TimerQueue is a min-heap of repeating timers keyed on absolute fire time,
+ *  so each tick only touches the timers that actually fire.
+ *
+ * Timers carry an (id, generation) pair chosen by the caller; PongSim uses
+ *  building handles, and drops timers whose building has since been destroyed
+ *  when they come up (rather than searching the heap at destroy time).
+ */
+
+struct TimerQueue {
+	struct Timer {
+		double time = 0.0; //absolute time of next firing
+		float period = 0.0f; //time between firings
+		uint32_t id = 0;
+		uint32_t generation = 0;
+		uint64_t order = 0; //tie-breaker so equal-time timers fire in the order they were scheduled
+	};
+
+	//add a timer that first fires at 'time' and then every 'period' seconds:
+	void schedule(double time, float period, uint32_t id, uint32_t generation);
+
+	//if a timer fires strictly before 'now', remove it from the queue, store it in *timer, and
+	// return how many times it has fired by 'now' (catching up on all missed periods at once);
+	// the caller should reschedule() it to keep it running.
+	//returns 0 if nothing is due:
+	uint32_t pop_due(double now, Timer *timer);
+
+	//put a popped timer back, 'fires' periods later than it was due:
+	void reschedule(Timer const &timer, uint32_t fires);
+
+	void clear() { heap.clear(); }
+	size_t size() const { return heap.size(); }
+
+	//----- internals -----
+	std::vector< Timer > heap;
+	uint64_t next_order = 0;
+	void push(Timer const &timer);
+};
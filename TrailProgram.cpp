@@ -0,0 +1,89 @@
+#include "TrailProgram.hpp"
+
+#include "BallTrail.hpp"
+#include "gl_compile_program.hpp"
+#include "gl_errors.hpp"
+
+#include <string>
+
+TrailProgram::TrailProgram() {
+	program = gl_compile_program(
+		//vertex shader:
+		"#version 330\n"
+		"uniform mat4 OBJECT_TO_CLIP;\n"
+		"uniform samplerBuffer SAMPLES;\n"
+		"uniform int FIRST;\n"
+		"uniform int COUNT;\n"
+		"uniform float NOW;\n"
+		"uniform float LENGTH;\n"
+		"uniform int STEPS;\n"
+		"uniform vec2 RADIUS;\n"
+		"uniform vec4 COLORS[" + std::to_string(MaxColors) + "];\n"
+		"uniform int COLOR_COUNT;\n"
+		"out vec4 color;\n"
+		"const int CAPACITY = " + std::to_string(BallTrail::Capacity) + ";\n"
+		"const vec2 CORNERS[6] = vec2[6](vec2(-1.0,-1.0), vec2(1.0,-1.0), vec2(1.0, 1.0), vec2(-1.0,-1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));\n"
+		//sample i, counting from the oldest, as (x, y, time, unused):
+		"vec4 sample_at(int i) {\n"
+		"	return texelFetch(SAMPLES, (FIRST + i) % CAPACITY);\n"
+		"}\n"
+		"void main() {\n"
+		"	int step = STEPS - gl_InstanceID;\n"
+		"	float t = NOW - float(step) / float(STEPS) * LENGTH;\n"
+		//find the last sample at or before t (binary search; samples are in time order):
+		"	int lo = 0;\n"
+		"	int hi = COUNT - 2;\n"
+		"	while (lo < hi) {\n"
+		"		int mid = (lo + hi + 1) / 2;\n"
+		"		if (sample_at(mid).z <= t) lo = mid;\n"
+		"		else hi = mid - 1;\n"
+		"	}\n"
+		"	vec4 a = sample_at(lo);\n"
+		"	vec4 b = sample_at(lo + 1);\n"
+		"	float f = clamp((t - a.z) / max(b.z - a.z, 1e-6), 0.0, 1.0);\n"
+		"	vec2 at = mix(a.xy, b.xy, f);\n"
+		"	gl_Position = OBJECT_TO_CLIP * vec4(at + CORNERS[gl_VertexID] * RADIUS, 0.0, 1.0);\n"
+		//color gradient from newest (step == 1) to oldest (step == STEPS); a single step gets the newest color:
+		"	float c = (STEPS > 1 ? float(step - 1) / float(STEPS - 1) : 0.0) * float(COLOR_COUNT);\n"
+		"	int ci = int(floor(c));\n"
+		"	float cf = c - float(ci);\n"
+		"	if (ci > COLOR_COUNT - 2) {\n"
+		"		ci = COLOR_COUNT - 2;\n"
+		"		cf = 1.0;\n"
+		"	}\n"
+		"	color = mix(COLORS[ci], COLORS[ci+1], cf);\n"
+		"}\n"
+	,
+		//fragment shader:
+		"#version 330\n"
+		"in vec4 color;\n"
+		"out vec4 fragColor;\n"
+		"void main() {\n"
+		"	fragColor = color;\n"
+		"}\n"
+	);
+
+	//look up the locations of uniforms:
+	OBJECT_TO_CLIP_mat4 = glGetUniformLocation(program, "OBJECT_TO_CLIP");
+	FIRST_int = glGetUniformLocation(program, "FIRST");
+	COUNT_int = glGetUniformLocation(program, "COUNT");
+	NOW_float = glGetUniformLocation(program, "NOW");
+	LENGTH_float = glGetUniformLocation(program, "LENGTH");
+	STEPS_int = glGetUniformLocation(program, "STEPS");
+	RADIUS_vec2 = glGetUniformLocation(program, "RADIUS");
+	COLORS_vec4_array = glGetUniformLocation(program, "COLORS");
+	COLOR_COUNT_int = glGetUniformLocation(program, "COLOR_COUNT");
+	GLuint SAMPLES_samplerBuffer = glGetUniformLocation(program, "SAMPLES");
+
+	//set SAMPLES to always refer to texture binding zero:
+	glUseProgram(program);
+	glUniform1i(SAMPLES_samplerBuffer, 0);
+	glUseProgram(0);
+
+	GL_ERRORS();
+}
+
+TrailProgram::~TrailProgram() {
+	glDeleteProgram(program);
+	program = 0;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "GL.hpp"
+
+#include <cstdint>
+
+//Shader program that draws the ball's trail from a BallTrail's samples:
+// instance i of a six-vertex draw is a square at the ball's interpolated position
+// 'LENGTH * (STEPS - i) / STEPS' seconds before NOW, colored by its place along the
+// COLORS gradient (so draw STEPS instances, oldest first). There are no vertex
+// attributes (corners come from gl_VertexID), but a vertex array must still be bound.
+struct TrailProgram {
+	TrailProgram();
+	~TrailProgram();
+
+	GLuint program = 0;
+
+	//most gradient colors COLORS can hold:
+	static constexpr uint32_t MaxColors = 8;
+
+	//Uniform (per-invocation variable) locations:
+	GLuint OBJECT_TO_CLIP_mat4 = -1U;
+	GLuint FIRST_int = -1U; //ring slot of the oldest sample
+	GLuint COUNT_int = -1U; //number of samples (at least 2)
+	GLuint NOW_float = -1U; //current time, on the same clock as the samples
+	GLuint LENGTH_float = -1U; //how far back the trail reaches, in seconds
+	GLuint STEPS_int = -1U; //(at least 1)
+	GLuint RADIUS_vec2 = -1U;
+	GLuint COLORS_vec4_array = -1U; //gradient from newest to oldest, as [0,1] RGBA
+	GLuint COLOR_COUNT_int = -1U; //(at least 2)
+
+	//Textures:
+	//TEXTURE0 - GL_TEXTURE_BUFFER (RGBA32F) holding the ring of BallTrail::Sample's
+};
@@ -0,0 +1,178 @@
+#include "aabb_overlap.hpp"
+
+#include <cassert>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define AABB_OVERLAP_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+//GCC/clang need to be told a function may use AVX2 instructions (MSVC doesn't):
+#if defined(AABB_OVERLAP_X86) && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+
+typedef uint32_t (*BatchFn)(float, float, float, float, float const *, float const *, uint32_t, uint32_t *);
+
+//all implementations take the query center and the summed radii (rx,ry):
+// box i overlaps iff |xs[i] - cx| <= rx && |ys[i] - cy| <= ry
+
+static uint32_t batch_scalar(float cx, float cy, float rx, float ry, float const *xs, float const *ys, uint32_t begin, uint32_t count, uint32_t *hits) {
+	uint32_t n = 0;
+	for (uint32_t i = begin; i < count; ++i) {
+		if (std::abs(xs[i] - cx) <= rx && std::abs(ys[i] - cy) <= ry) {
+			hits[n++] = i;
+		}
+	}
+	return n;
+}
+
+static uint32_t overlap_scalar(float cx, float cy, float rx, float ry, float const *xs, float const *ys, uint32_t count, uint32_t *hits) {
+	return batch_scalar(cx, cy, rx, ry, xs, ys, 0, count, hits);
+}
+
+#ifdef AABB_OVERLAP_X86
+
+//write the indices of set bits in 'mask' (offset by 'base') to hits:
+static inline uint32_t emit_hits(uint32_t mask, uint32_t base, uint32_t *hits) {
+	uint32_t n = 0;
+	while (mask) {
+		#ifdef _MSC_VER
+		unsigned long bit;
+		_BitScanForward(&bit, mask);
+		#else
+		uint32_t bit = uint32_t(__builtin_ctz(mask));
+		#endif
+		hits[n++] = base + uint32_t(bit);
+		mask &= mask - 1;
+	}
+	return n;
+}
+
+static uint32_t overlap_sse2(float cx, float cy, float rx, float ry, float const *xs, float const *ys, uint32_t count, uint32_t *hits) {
+	__m128 const vcx = _mm_set1_ps(cx);
+	__m128 const vcy = _mm_set1_ps(cy);
+	__m128 const vrx = _mm_set1_ps(rx);
+	__m128 const vry = _mm_set1_ps(ry);
+	__m128 const sign = _mm_set1_ps(-0.0f);
+
+	uint32_t n = 0;
+	uint32_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m128 dx = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(xs + i), vcx));
+		__m128 dy = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(ys + i), vcy));
+		__m128 in = _mm_and_ps(_mm_cmple_ps(dx, vrx), _mm_cmple_ps(dy, vry));
+		uint32_t mask = uint32_t(_mm_movemask_ps(in));
+		if (mask) n += emit_hits(mask, i, hits + n);
+	}
+	n += batch_scalar(cx, cy, rx, ry, xs, ys, i, count, hits + n);
+	return n;
+}
+
+TARGET_AVX2
+static uint32_t overlap_avx2(float cx, float cy, float rx, float ry, float const *xs, float const *ys, uint32_t count, uint32_t *hits) {
+	__m256 const vcx = _mm256_set1_ps(cx);
+	__m256 const vcy = _mm256_set1_ps(cy);
+	__m256 const vrx = _mm256_set1_ps(rx);
+	__m256 const vry = _mm256_set1_ps(ry);
+	__m256 const sign = _mm256_set1_ps(-0.0f);
+
+	uint32_t n = 0;
+	uint32_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 dx = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(xs + i), vcx));
+		__m256 dy = _mm256_andnot_ps(sign, _mm256_sub_ps(_mm256_loadu_ps(ys + i), vcy));
+		__m256 in = _mm256_and_ps(_mm256_cmp_ps(dx, vrx, _CMP_LE_OQ), _mm256_cmp_ps(dy, vry, _CMP_LE_OQ));
+		uint32_t mask = uint32_t(_mm256_movemask_ps(in));
+		if (mask) n += emit_hits(mask, i, hits + n);
+	}
+	n += batch_scalar(cx, cy, rx, ry, xs, ys, i, count, hits + n);
+	return n;
+}
+
+static bool cpu_has_avx2() {
+	#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) return false;
+	__cpuid(info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) return false;
+	//OS must save the ymm registers:
+	if ((_xgetbv(0) & 6) != 6) return false;
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+	#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+	#endif
+}
+
+#endif //AABB_OVERLAP_X86
+
+bool aabb_overlap_supported(AABBOverlapImpl impl) {
+	switch (impl) {
+		case AABBOverlapScalar: return true;
+		#ifdef AABB_OVERLAP_X86
+		case AABBOverlapSSE2: return true; //(part of x86-64; assumed on 32-bit x86 as well)
+		case AABBOverlapAVX2: {
+			static bool const has_avx2 = cpu_has_avx2();
+			return has_avx2;
+		}
+		#else
+		case AABBOverlapSSE2: return false;
+		case AABBOverlapAVX2: return false;
+		#endif
+	}
+	return false;
+}
+
+char const *aabb_overlap_name(AABBOverlapImpl impl) {
+	switch (impl) {
+		case AABBOverlapScalar: return "scalar";
+		case AABBOverlapSSE2: return "sse2";
+		case AABBOverlapAVX2: return "avx2";
+	}
+	return "unknown";
+}
+
+AABBOverlapImpl aabb_overlap_best() {
+	if (aabb_overlap_supported(AABBOverlapAVX2)) return AABBOverlapAVX2;
+	if (aabb_overlap_supported(AABBOverlapSSE2)) return AABBOverlapSSE2;
+	return AABBOverlapScalar;
+}
+
+static BatchFn impl_fn(AABBOverlapImpl impl) {
+	assert(aabb_overlap_supported(impl));
+	#ifdef AABB_OVERLAP_X86
+	if (impl == AABBOverlapAVX2) return overlap_avx2;
+	if (impl == AABBOverlapSSE2) return overlap_sse2;
+	#endif
+	return overlap_scalar;
+}
+
+uint32_t aabb_overlap_batch(
+	AABBOverlapImpl impl,
+	glm::vec2 const &center, glm::vec2 const &radius,
+	float const *xs, float const *ys, uint32_t count, glm::vec2 const &other_radius,
+	uint32_t *hits) {
+	glm::vec2 reach = radius + other_radius;
+	return impl_fn(impl)(center.x, center.y, reach.x, reach.y, xs, ys, count, hits);
+}
+
+uint32_t aabb_overlap_batch(
+	glm::vec2 const &center, glm::vec2 const &radius,
+	float const *xs, float const *ys, uint32_t count, glm::vec2 const &other_radius,
+	uint32_t *hits) {
+	//(picked once, on first use)
+	static BatchFn const best = impl_fn(aabb_overlap_best());
+	glm::vec2 reach = radius + other_radius;
+	return best(center.x, center.y, reach.x, reach.y, xs, ys, count, hits);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+
+/*
+ * Batched axis-aligned box overlap tests.
+ *
+ * Tests one box (center, radius) against 'count' boxes of the same half-size
+ *  'other_radius' whose centers are packed in xs[] / ys[].
+ * Touching boxes count as overlapping (same as PongSim::overlaps).
+ *
+ * Writes the index of every overlapping box to hits[] in increasing order
+ *  (hits must have room for 'count' entries) and returns the number written.
+ *
+ * aabb_overlap_batch() picks the fastest implementation the CPU supports
+ *  (AVX2, SSE2, or plain scalar code) the first time it is called.
+ */
+
+uint32_t aabb_overlap_batch(
+	glm::vec2 const &center, glm::vec2 const &radius,
+	float const *xs, float const *ys, uint32_t count, glm::vec2 const &other_radius,
+	uint32_t *hits);
+
+//----- individual implementations (for benchmarking + testing) -----
+
+enum AABBOverlapImpl {
+	AABBOverlapScalar,
+	AABBOverlapSSE2,
+	AABBOverlapAVX2,
+};
+
+//can this implementation run on this CPU (and was it compiled in)?
+bool aabb_overlap_supported(AABBOverlapImpl impl);
+
+//human-readable name of an implementation:
+char const *aabb_overlap_name(AABBOverlapImpl impl);
+
+//implementation that aabb_overlap_batch() dispatches to:
+AABBOverlapImpl aabb_overlap_best();
+
+//run a specific implementation (must be supported):
+uint32_t aabb_overlap_batch(
+	AABBOverlapImpl impl,
+	glm::vec2 const &center, glm::vec2 const &radius,
+	float const *xs, float const *ys, uint32_t count, glm::vec2 const &other_radius,
+	uint32_t *hits);
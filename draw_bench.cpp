@@ -0,0 +1,388 @@
+//draw_bench.cpp times PongMode::draw() on synthetic scenes of increasing size,
+// to see how the draw path scales and to compare rendering strategies.
+//Each scene has a given number of buildings, bullets, trail squares, and money;
+// the scene is held still (except for the ball, which circles to keep its trail
+// moving) and drawn for a number of frames after a warm-up.
+//Draws offscreen (see OffscreenContext) on Linux unless --window is given;
+// elsewhere always in a window.
+
+//The 'PongMode' mode draws the game:
+#include "PongMode.hpp"
+
+#ifdef __linux__
+//windowless GL context + framebuffer:
+#include "OffscreenContext.hpp"
+#endif
+
+//for the GL_ERRORS() macro and debug output:
+#include "gl_errors.hpp"
+
+//Includes for libSDL:
+#include <SDL.h>
+
+//...and for c++ standard library functions:
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct Scene {
+	uint32_t buildings = 0;
+	uint32_t bullets = 0;
+	uint32_t trail_steps = 20;
+	uint32_t money = 0;
+};
+
+//per-scene results (means over the timed frames):
+struct Result {
+	Scene scene;
+	uint32_t frames = 0;
+	double submit_ms = 0.0; //PongMode::draw() building + submitting draws ("vertex generation")
+	double upload_ms = 0.0; //...uploading them
+	double flush_ms = 0.0; //...issuing them (draw_list->flush)
+	double frame_ms = 0.0; //the whole draw() plus waiting for the GPU (glFinish, or swap + glFinish in a window)
+	double frame_ms_median = 0.0;
+	double frame_ms_max = 0.0;
+	double gpu_ms = 0.0; //GPU time for the frame (rolling average over the last timed frames)
+	double upload_bytes = 0.0; //streamed + retained-layer bytes
+	double draw_calls = 0.0;
+	double state_changes = 0.0;
+	double vertices = 0.0;
+};
+
+//fill 'mode' with a synthetic scene (buildings + bullets scattered over the court):
+static void build_scene(PongMode &mode, Scene const &scene, std::mt19937 &mt) {
+	PongSim &sim = mode.sim;
+	std::uniform_real_distribution< float > x(-sim.court_radius.x + sim.building_radius.x, sim.court_radius.x - sim.building_radius.x);
+	std::uniform_real_distribution< float > y(-sim.court_radius.y + sim.building_radius.y, sim.court_radius.y - sim.building_radius.y);
+
+	//(placement rules and prices don't matter here; buildings may overlap)
+	int const types[3] = { BUILDING_SHOOTER, BUILDING_WALL, BUILDING_FARM };
+	for (uint32_t i = 0; i < scene.buildings; ++i) {
+		int side = (i % 2 ? SIDE_RIGHT : SIDE_LEFT);
+		(side == SIDE_LEFT ? sim.left_money : sim.right_money) = FARM_PRICE;
+		sim.place_building(side, types[(i / 2) % 3], glm::vec2(x(mt), y(mt)));
+	}
+
+	sim.bullets = Bullets(std::max(scene.bullets, sim.bullets.capacity()));
+	for (uint32_t i = 0; i < scene.bullets; ++i) {
+		sim.bullets.spawn(glm::vec2(x(mt), y(mt)), (i % 2 ? SIDE_RIGHT : SIDE_LEFT));
+	}
+
+	sim.left_money = scene.money;
+	sim.right_money = scene.money;
+}
+
+//move the ball one step around a loop of the court (and record it in the trail):
+static void step_ball(PongSim &sim, float tick) {
+	sim.time += tick;
+	float angle = float(sim.time) * 2.0f;
+	sim.ball = glm::vec2(std::cos(angle) * 0.6f * sim.court_radius.x, std::sin(angle) * 0.6f * sim.court_radius.y);
+	sim.ball_trail.push(sim.ball, float(sim.time));
+}
+
+//"10,100,0,5" -> Scene:
+static Scene parse_scene(std::string const &val) {
+	std::vector< uint32_t > fields;
+	size_t begin = 0;
+	while (true) {
+		size_t end = val.find(',', begin);
+		fields.emplace_back(uint32_t(std::stoul(val.substr(begin, end - begin))));
+		if (end == std::string::npos) break;
+		begin = end + 1;
+	}
+	if (fields.size() != 4) throw std::invalid_argument("scene needs four fields");
+	Scene scene;
+	scene.buildings = fields[0];
+	scene.bullets = fields[1];
+	scene.trail_steps = fields[2];
+	scene.money = fields[3];
+	return scene;
+}
+
+int main(int argc, char **argv) {
+#ifdef _WIN32
+	//when compiled on windows, unhandled exceptions don't have their message printed, which can make debugging simple issues difficult.
+	try {
+#endif
+
+	//------------ command line ------------
+
+	glm::uvec2 size = glm::uvec2(640, 480);
+	uint32_t frames = 200; //timed frames per scene
+	uint32_t warmup = 20; //untimed frames drawn before those (first uploads, shader warm-up)
+	uint32_t seed = 0;
+	std::vector< Scene > scenes;
+	bool windowed = false;
+#ifndef __linux__
+	windowed = true; //(offscreen contexts are only made on Linux)
+#endif
+	std::string json_file = "";
+	std::string csv_file = "";
+
+	auto usage = [&]() {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--scene BUILDINGS,BULLETS,TRAIL_STEPS,MONEY]... [--frames N] [--warmup N] [--size WxH] [--seed S]\n"
+		             "\t[--vertex-upload ring|orphan] [--window] [--json FILE] [--csv FILE]\n"
+		             "\t[--gl-debug off|callback|full] [--gl-debug-severity high|medium|low|notification]\n"
+		             "\t(default scenes: N,N,20,N for N = 10, 100, 1000, 10000)" << std::endl;
+	};
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (arg == "--window") {
+			windowed = true;
+			continue;
+		}
+		if (argi + 1 >= argc) {
+			usage();
+			return 1;
+		}
+		std::string val = argv[++argi];
+		try {
+			if (arg == "--scene") scenes.emplace_back(parse_scene(val));
+			else if (arg == "--frames") frames = uint32_t(std::stoul(val));
+			else if (arg == "--warmup") warmup = uint32_t(std::stoul(val));
+			else if (arg == "--seed") seed = uint32_t(std::stoul(val));
+			else if (arg == "--size") {
+				size_t x = val.find('x');
+				if (x == std::string::npos) throw std::invalid_argument("no 'x'");
+				size = glm::uvec2(uint32_t(std::stoul(val.substr(0, x))), uint32_t(std::stoul(val.substr(x+1))));
+			}
+			else if (arg == "--vertex-upload" && val == "ring") PongMode::vertex_upload = StreamBuffer::Ring;
+			else if (arg == "--vertex-upload" && val == "orphan") PongMode::vertex_upload = StreamBuffer::Orphan;
+			else if (arg == "--json") json_file = val;
+			else if (arg == "--csv") csv_file = val;
+			else if (arg == "--gl-debug" && gl_debug_level_from_string(val) >= 0) gl_debug_level = gl_debug_level_from_string(val);
+			else if (arg == "--gl-debug-severity" && gl_debug_severity_from_string(val) != 0) gl_debug_min_severity = gl_debug_severity_from_string(val);
+			else {
+				usage();
+				return 1;
+			}
+		} catch (std::exception const &) {
+			std::cerr << "Bad value '" << val << "' for '" << arg << "'." << std::endl;
+			return 1;
+		}
+	}
+	if (frames == 0 || size.x == 0 || size.y == 0) {
+		std::cerr << "Frame count and size must be positive." << std::endl;
+		return 1;
+	}
+	if (scenes.empty()) {
+		for (uint32_t n : { 10U, 100U, 1000U, 10000U }) {
+			Scene scene;
+			scene.buildings = n;
+			scene.bullets = n;
+			scene.money = n;
+			scenes.emplace_back(scene);
+		}
+	}
+
+	//------------ GL context ------------
+
+	std::string context_description;
+	SDL_Window *window = nullptr;
+	SDL_GLContext context = nullptr;
+#ifdef __linux__
+	std::unique_ptr< OffscreenContext > offscreen;
+#endif
+
+	bool debug_context = (gl_debug_level >= GL_DEBUG_FULL && PONG_GL_DEBUG >= GL_DEBUG_FULL);
+	if (windowed) {
+		SDL_Init(SDL_INIT_VIDEO);
+		SDL_GL_ResetAttributes();
+		SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_BLUE_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_ALPHA_SIZE, 8);
+		SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+		if (debug_context) SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+		window = SDL_CreateWindow("draw-bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, size.x, size.y, SDL_WINDOW_OPENGL);
+		if (!window) {
+			std::cerr << "Error creating SDL window: " << SDL_GetError() << std::endl;
+			return 1;
+		}
+		context = SDL_GL_CreateContext(window);
+		if (!context) {
+			SDL_DestroyWindow(window);
+			std::cerr << "Error creating OpenGL context: " << SDL_GetError() << std::endl;
+			return 1;
+		}
+		init_GL();
+		gl_debug_init();
+		//don't wait for vsync (we want to know how long frames take, not the refresh rate):
+		SDL_GL_SetSwapInterval(0);
+
+		int w, h;
+		SDL_GL_GetDrawableSize(window, &w, &h);
+		size = glm::uvec2(w, h);
+		glViewport(0, 0, size.x, size.y);
+		context_description = std::string("window: ") + (char const *)glGetString(GL_RENDERER);
+	} else {
+#ifdef __linux__
+		try {
+			offscreen.reset(new OffscreenContext(size, debug_context));
+		} catch (std::exception const &e) {
+			std::cerr << "Failed to create an offscreen GL context (try --window): " << e.what() << std::endl;
+			return 1;
+		}
+		gl_debug_init(OffscreenContext::get_proc_address);
+		context_description = offscreen->description;
+#endif
+	}
+
+	std::cout << "Drawing " << size.x << "x" << size.y << " frames with " << context_description
+	          << " (" << (PongMode::vertex_upload == StreamBuffer::Ring ? "ring" : "orphan") << " vertex upload)" << std::endl;
+
+	//------------ scenes ------------
+
+	std::vector< Result > results;
+	float const tick = 1.0f / 60.0f;
+
+	for (Scene const &scene : scenes) {
+		std::mt19937 mt(seed);
+		PongMode::trail_steps = scene.trail_steps;
+		std::shared_ptr< PongMode > mode = std::make_shared< PongMode >(seed);
+		build_scene(*mode, scene, mt);
+
+		Result result;
+		result.scene = scene;
+		std::vector< double > frame_ms;
+
+		for (uint32_t frame = 0; frame < warmup + frames; ++frame) {
+			if (windowed) {
+				//(keep the window responsive)
+				SDL_Event evt;
+				while (SDL_PollEvent(&evt) == 1) { }
+			}
+			step_ball(mode->sim, tick);
+
+			auto before = std::chrono::high_resolution_clock::now();
+			mode->draw(size);
+			if (windowed) SDL_GL_SwapWindow(window);
+			glFinish();
+			auto after = std::chrono::high_resolution_clock::now();
+
+			if (frame < warmup) continue;
+
+			DrawList::Stats const &stats = mode->draw_list->stats;
+			result.frames += 1;
+			result.submit_ms += mode->draw_ms.submit;
+			result.upload_ms += mode->draw_ms.upload;
+			result.flush_ms += mode->draw_ms.flush;
+			result.upload_bytes += double(stats.upload_bytes + mode->layer_upload_bytes);
+			result.draw_calls += stats.draw_calls;
+			result.state_changes += stats.state_changes;
+			result.vertices += stats.vertices;
+			frame_ms.emplace_back(std::chrono::duration< double, std::milli >(after - before).count());
+		}
+
+		double n = double(result.frames);
+		result.submit_ms /= n;
+		result.upload_ms /= n;
+		result.flush_ms /= n;
+		result.upload_bytes /= n;
+		result.draw_calls /= n;
+		result.state_changes /= n;
+		result.vertices /= n;
+		for (double ms : frame_ms) result.frame_ms += ms;
+		result.frame_ms /= n;
+		std::sort(frame_ms.begin(), frame_ms.end());
+		result.frame_ms_median = frame_ms[frame_ms.size() / 2];
+		result.frame_ms_max = frame_ms.back();
+		result.gpu_ms = (mode->gpu_timer->scopes.empty() ? 0.0 : mode->gpu_timer->scopes[0].average());
+
+		std::cout << "  " << scene.buildings << " buildings, " << scene.bullets << " bullets, " << scene.trail_steps << " trail steps, $" << scene.money << ":\n"
+		          << "    frame " << result.frame_ms << " ms (median " << result.frame_ms_median << ", max " << result.frame_ms_max << "), gpu " << result.gpu_ms << " ms\n"
+		          << "    cpu: submit " << result.submit_ms << " ms, upload " << result.upload_ms << " ms, flush " << result.flush_ms << " ms\n"
+		          << "    " << result.draw_calls << " draw calls, " << result.state_changes << " state changes, " << result.vertices << " vertices, "
+		          << result.upload_bytes << " bytes uploaded per frame" << std::endl;
+
+		results.emplace_back(result);
+	}
+
+	GL_ERRORS();
+
+	//------------ output ------------
+
+	if (csv_file != "") {
+		std::ofstream csv(csv_file, std::ios::binary);
+		if (!csv) {
+			std::cerr << "Failed to open '" << csv_file << "' for writing." << std::endl;
+			return 1;
+		}
+		csv << "buildings,bullets,trail_steps,money,frames,submit_ms,upload_ms,flush_ms,frame_ms,frame_ms_median,frame_ms_max,gpu_ms,upload_bytes,draw_calls,state_changes,vertices\n";
+		for (Result const &r : results) {
+			csv << r.scene.buildings << ',' << r.scene.bullets << ',' << r.scene.trail_steps << ',' << r.scene.money << ',' << r.frames
+				<< ',' << r.submit_ms << ',' << r.upload_ms << ',' << r.flush_ms
+				<< ',' << r.frame_ms << ',' << r.frame_ms_median << ',' << r.frame_ms_max << ',' << r.gpu_ms
+				<< ',' << r.upload_bytes << ',' << r.draw_calls << ',' << r.state_changes << ',' << r.vertices << '\n';
+		}
+		std::cout << "Wrote results to '" << csv_file << "'." << std::endl;
+	}
+
+	if (json_file != "") {
+		std::ofstream json(json_file, std::ios::binary);
+		if (!json) {
+			std::cerr << "Failed to open '" << json_file << "' for writing." << std::endl;
+			return 1;
+		}
+		//(the description is the only free text; keep it JSON-safe)
+		std::string description = context_description;
+		for (char &c : description) {
+			if (c == '"' || c == '\\' || uint8_t(c) < 0x20) c = ' ';
+		}
+		json << "{\n";
+		json << "\t\"context\": \"" << description << "\",\n";
+		json << "\t\"size\": [" << size.x << ", " << size.y << "],\n";
+		json << "\t\"vertex_upload\": \"" << (PongMode::vertex_upload == StreamBuffer::Ring ? "ring" : "orphan") << "\",\n";
+		json << "\t\"scenes\": [\n";
+		for (size_t i = 0; i < results.size(); ++i) {
+			Result const &r = results[i];
+			json << "\t\t{ \"buildings\": " << r.scene.buildings << ", \"bullets\": " << r.scene.bullets
+			     << ", \"trail_steps\": " << r.scene.trail_steps << ", \"money\": " << r.scene.money << ", \"frames\": " << r.frames
+			     << ", \"submit_ms\": " << r.submit_ms << ", \"upload_ms\": " << r.upload_ms << ", \"flush_ms\": " << r.flush_ms
+			     << ", \"frame_ms\": " << r.frame_ms << ", \"frame_ms_median\": " << r.frame_ms_median << ", \"frame_ms_max\": " << r.frame_ms_max
+			     << ", \"gpu_ms\": " << r.gpu_ms << ", \"upload_bytes\": " << r.upload_bytes << ", \"draw_calls\": " << r.draw_calls
+			     << ", \"state_changes\": " << r.state_changes << ", \"vertices\": " << r.vertices << " }"
+			     << (i + 1 < results.size() ? "," : "") << "\n";
+		}
+		json << "\t]\n";
+		json << "}\n";
+		std::cout << "Wrote results to '" << json_file << "'." << std::endl;
+	}
+
+	//------------ teardown ------------
+
+#ifdef __linux__
+	offscreen.reset();
+#endif
+	if (windowed) {
+		SDL_GL_DeleteContext(context);
+		context = 0;
+		SDL_DestroyWindow(window);
+		window = NULL;
+		SDL_Quit();
+	}
+
+	return 0;
+
+#ifdef _WIN32
+	} catch (std::exception const &e) {
+		std::cerr << "Unhandled exception:\n" << e.what() << std::endl;
+		return 1;
+	} catch (...) {
+		std::cerr << "Unhandled exception (unknown type)." << std::endl;
+		return 1;
+	}
+#endif
+}
@@ -1,10 +1,193 @@
 #include "gl_compile_program.hpp"
 
+#include "GLResources.hpp"
+
+#include <SDL.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <vector>
 #include <string>
 #include <stdexcept>
 #include <iostream>
 
+#ifdef _WIN32
+	#include <process.h>
+	#define getpid _getpid
+#else
+	#include <unistd.h>
+#endif
+
+//---- program binary cache ----
+//glGetProgramBinary/glProgramBinary are GL 4.1 (or ARB_get_program_binary), not GL 3.3 core,
+// so GL.hpp doesn't declare them; they're looked up at runtime instead:
+
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+typedef void (APIENTRY *PFN_glGetProgramBinary) (GLuint program, GLsizei bufSize, GLsizei *length, GLenum *binaryFormat, void *binary);
+typedef void (APIENTRY *PFN_glProgramBinary) (GLuint program, GLenum binaryFormat, const void *binary, GLsizei length);
+typedef void (APIENTRY *PFN_glProgramParameteri) (GLuint program, GLenum pname, GLint value);
+
+static struct {
+	bool enabled = false;
+	std::string directory;
+	std::string driver; //vendor + renderer + version (part of every key)
+
+	PFN_glGetProgramBinary GetProgramBinary = nullptr;
+	PFN_glProgramBinary ProgramBinary = nullptr;
+	PFN_glProgramParameteri ProgramParameteri = nullptr;
+
+	uint32_t hits = 0;
+	uint32_t misses = 0; //(includes rejected)
+	uint32_t rejected = 0; //binary found but the driver wouldn't take it
+	double saved_ms = 0.0; //compile time recorded with each hit's binary, minus time to load it
+} cache;
+
+//file layout: header, then 'key_length' bytes of key, then 'length' bytes of binary:
+// (the whole key is stored so a file name hash collision is a miss, not the wrong program)
+struct CacheHeader {
+	char magic[4]; //"PBC2"
+	uint32_t format; //binaryFormat from glGetProgramBinary
+	uint32_t key_length;
+	uint32_t length;
+	uint32_t compile_us; //time it took to compile + link from source (for reporting time saved)
+};
+static_assert(sizeof(CacheHeader) == 20, "CacheHeader should be packed");
+
+bool gl_program_cache_init(std::string const &directory) {
+	cache.enabled = false;
+
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	bool supported = (major > 4 || (major == 4 && minor >= 1));
+	if (!supported) {
+		GLint extensions = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+		for (GLint i = 0; i < extensions; ++i) {
+			if (std::strcmp(reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, i)), "GL_ARB_get_program_binary") == 0) {
+				supported = true;
+				break;
+			}
+		}
+	}
+	GLint formats = 0;
+	if (supported) glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (!supported || formats == 0) {
+		std::cerr << "NOTE: driver doesn't support program binaries; shaders will always compile from source." << std::endl;
+		return false;
+	}
+
+	cache.GetProgramBinary = (PFN_glGetProgramBinary)SDL_GL_GetProcAddress("glGetProgramBinary");
+	cache.ProgramBinary = (PFN_glProgramBinary)SDL_GL_GetProcAddress("glProgramBinary");
+	cache.ProgramParameteri = (PFN_glProgramParameteri)SDL_GL_GetProcAddress("glProgramParameteri");
+	if (!cache.GetProgramBinary || !cache.ProgramBinary || !cache.ProgramParameteri) {
+		std::cerr << "NOTE: couldn't find program binary entry points; shaders will always compile from source." << std::endl;
+		return false;
+	}
+
+	auto str = [](GLenum name) -> std::string {
+		GLubyte const *s = glGetString(name);
+		return s ? reinterpret_cast< char const * >(s) : "";
+	};
+	cache.driver = str(GL_VENDOR) + "\n" + str(GL_RENDERER) + "\n" + str(GL_VERSION) + "\n";
+	cache.directory = directory;
+	cache.enabled = true;
+	return true;
+}
+
+void gl_program_cache_report() {
+	if (!cache.enabled) return;
+	char saved[32];
+	std::snprintf(saved, sizeof(saved), "%.1f", cache.saved_ms);
+	std::cout << "program cache: " << cache.hits << " hits, " << cache.misses << " misses"
+	          << " (" << cache.rejected << " rejected by driver); saved ~" << saved << " ms of shader compiles." << std::endl;
+}
+
+static std::string cache_key(std::string const &vertex_shader_source, std::string const &fragment_shader_source) {
+	//(sources are length-prefixed so moving text between them changes the key)
+	return cache.driver
+		+ std::to_string(vertex_shader_source.size()) + ":" + vertex_shader_source
+		+ std::to_string(fragment_shader_source.size()) + ":" + fragment_shader_source;
+}
+
+static std::string cache_path(std::string const &key) {
+	return cache.directory + "program-" + GLResources::hash(key) + ".bin";
+}
+
+//a linked program from the cached binary for 'key' at 'path', or 0 if there isn't a usable one:
+static GLuint cache_load(std::string const &path, std::string const &key, uint32_t *compile_us) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	if (!file) return 0;
+	std::streamoff size = file.tellg();
+	file.seekg(0);
+	CacheHeader header;
+	if (!file.read(reinterpret_cast< char * >(&header), sizeof(header))) return 0;
+	if (std::memcmp(header.magic, "PBC2", 4) != 0) return 0;
+	//(lengths must account for exactly the rest of the file, so a corrupt header can't ask for a huge allocation)
+	if (size < 0 || std::streamoff(sizeof(header)) + header.key_length + header.length != size) return 0;
+	if (header.key_length != key.size()) return 0;
+	std::string stored_key(header.key_length, '\0');
+	if (!file.read(&stored_key[0], stored_key.size())) return 0;
+	if (stored_key != key) return 0;
+	std::vector< char > binary(header.length);
+	if (!file.read(binary.data(), binary.size())) return 0;
+
+	GLuint program = glCreateProgram();
+	cache.ProgramBinary(program, header.format, binary.data(), GLsizei(binary.size()));
+	//drivers reject binaries from other driver builds or hardware by failing the link:
+	GLint link_status = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &link_status);
+	if (link_status != GL_TRUE) {
+		glDeleteProgram(program);
+		cache.rejected += 1;
+		return 0;
+	}
+	*compile_us = header.compile_us;
+	return program;
+}
+
+static void cache_store(std::string const &path, std::string const &key, GLuint program, uint32_t compile_us) {
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+	std::vector< char > binary(length);
+	GLsizei got = 0;
+	GLenum format = 0;
+	cache.GetProgramBinary(program, length, &got, &format, binary.data());
+	if (got <= 0) return;
+
+	CacheHeader header;
+	std::memcpy(header.magic, "PBC2", 4);
+	header.format = format;
+	header.key_length = uint32_t(key.size());
+	header.length = uint32_t(got);
+	header.compile_us = compile_us;
+
+	//write to a temporary file and rename, so a crash never leaves a torn binary:
+	// (the temporary name includes the process id, so instances storing the same program don't write into each other's files)
+	std::string temp = path + "." + std::to_string(getpid()) + ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary);
+		file.write(reinterpret_cast< char const * >(&header), sizeof(header));
+		file.write(key.data(), key.size());
+		file.write(binary.data(), got);
+		if (!file) {
+			std::cerr << "NOTE: couldn't write program cache file '" << temp << "'." << std::endl;
+			file.close();
+			std::remove(temp.c_str());
+			return;
+		}
+	}
+	std::remove(path.c_str()); //(rename won't replace an existing file on windows)
+	std::rename(temp.c_str(), path.c_str());
+}
+
 static GLuint gl_compile_shader(GLenum type, std::string const &source) {
 	GLuint shader = glCreateShader(type);
 	GLchar const *str = source.c_str();
@@ -32,6 +215,25 @@ GLuint gl_compile_program(
 	std::string const &fragment_shader_source
 	) {
 
+	auto before = std::chrono::high_resolution_clock::now();
+	auto elapsed_us = [&before]() {
+		auto after = std::chrono::high_resolution_clock::now();
+		return uint32_t(std::chrono::duration_cast< std::chrono::microseconds >(after - before).count());
+	};
+
+	std::string key, path;
+	if (cache.enabled) {
+		key = cache_key(vertex_shader_source, fragment_shader_source);
+		path = cache_path(key);
+		uint32_t compile_us = 0;
+		if (GLuint program = cache_load(path, key, &compile_us)) {
+			cache.hits += 1;
+			cache.saved_ms += (double(compile_us) - double(elapsed_us())) / 1000.0;
+			return program;
+		}
+		cache.misses += 1;
+	}
+
 	GLuint vertex_shader = gl_compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
 	GLuint fragment_shader = gl_compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
 
@@ -43,6 +245,9 @@ GLuint gl_compile_program(
 	glDeleteShader(vertex_shader);
 	glDeleteShader(fragment_shader);
 
+	//ask the driver to keep a binary around for the cache:
+	if (cache.enabled) cache.ProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
 	//link the shader program and throw errors if linking fails:
 	glLinkProgram(program);
 	GLint link_status = GL_FALSE;
@@ -58,5 +263,7 @@ GLuint gl_compile_program(
 		throw std::runtime_error("failed to link program");
 	}
 
+	if (cache.enabled) cache_store(path, key, program, elapsed_us());
+
 	return program;
 }
@@ -6,6 +6,17 @@
 
 //compiles+links an OpenGL shader program from source.
 // throws on compilation error.
+// (if gl_program_cache_init() has been called, first tries a cached program binary)
 GLuint gl_compile_program(
 	std::string const &vertex_shader_source,
 	std::string const &fragment_shader_source);
+
+//enable the on-disk program binary cache (needs a current GL context):
+// binaries are stored as 'directory' + "program-<hash>.bin", keyed on both shader
+// sources and the GL vendor/renderer/version strings. Does nothing (and leaves
+// the cache off) if the driver can't hand out program binaries.
+// returns true if the cache is in use.
+bool gl_program_cache_init(std::string const &directory);
+
+//print cache hits/misses/rejections and approximate time saved so far:
+void gl_program_cache_report();
@@ -0,0 +1,172 @@
+#include "gl_errors.hpp"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <tuple>
+
+int gl_debug_level = (PONG_GL_DEBUG < GL_DEBUG_CALLBACK ? PONG_GL_DEBUG : GL_DEBUG_CALLBACK);
+
+//debug output is KHR_debug (core in GL 4.3) or ARB_debug_output, neither of which is in GL.hpp's 3.3 core:
+#define GL_DEBUG_OUTPUT                   0x92E0
+#define GL_DEBUG_OUTPUT_SYNCHRONOUS       0x8242
+#define GL_DEBUG_SOURCE_API               0x8246
+#define GL_DEBUG_SOURCE_WINDOW_SYSTEM     0x8247
+#define GL_DEBUG_SOURCE_SHADER_COMPILER   0x8248
+#define GL_DEBUG_SOURCE_THIRD_PARTY       0x8249
+#define GL_DEBUG_SOURCE_APPLICATION       0x824A
+#define GL_DEBUG_SOURCE_OTHER             0x824B
+#define GL_DEBUG_TYPE_ERROR               0x824C
+#define GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR 0x824D
+#define GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR  0x824E
+#define GL_DEBUG_TYPE_PORTABILITY         0x824F
+#define GL_DEBUG_TYPE_PERFORMANCE         0x8250
+#define GL_DEBUG_TYPE_OTHER               0x8251
+#define GL_DEBUG_SEVERITY_HIGH            0x9146
+#define GL_DEBUG_SEVERITY_MEDIUM          0x9147
+#define GL_DEBUG_SEVERITY_LOW             0x9148
+#define GL_DEBUG_SEVERITY_NOTIFICATION    0x826B
+
+GLenum gl_debug_min_severity = GL_DEBUG_SEVERITY_LOW;
+
+//(KHR_debug and ARB_debug_output callbacks and entry points have the same signatures)
+typedef void (APIENTRY *GLDEBUGPROC)(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *userParam);
+typedef void (APIENTRY *PFN_glDebugMessageCallback)(GLDEBUGPROC callback, const void *userParam);
+typedef void (APIENTRY *PFN_glDebugMessageControl)(GLenum source, GLenum type, GLenum severity, GLsizei count, const GLuint *ids, GLboolean enabled);
+
+int gl_debug_level_from_string(std::string const &name) {
+	if (name == "off") return GL_DEBUG_OFF;
+	if (name == "callback") return GL_DEBUG_CALLBACK;
+	if (name == "full") return GL_DEBUG_FULL;
+	return -1;
+}
+
+GLenum gl_debug_severity_from_string(std::string const &name) {
+	if (name == "high") return GL_DEBUG_SEVERITY_HIGH;
+	if (name == "medium") return GL_DEBUG_SEVERITY_MEDIUM;
+	if (name == "low") return GL_DEBUG_SEVERITY_LOW;
+	if (name == "notification") return GL_DEBUG_SEVERITY_NOTIFICATION;
+	return 0;
+}
+
+static char const *source_name(GLenum source) {
+	switch (source) {
+		case GL_DEBUG_SOURCE_API: return "api";
+		case GL_DEBUG_SOURCE_WINDOW_SYSTEM: return "window system";
+		case GL_DEBUG_SOURCE_SHADER_COMPILER: return "shader compiler";
+		case GL_DEBUG_SOURCE_THIRD_PARTY: return "third party";
+		case GL_DEBUG_SOURCE_APPLICATION: return "application";
+		default: return "other";
+	}
+}
+
+static char const *type_name(GLenum type) {
+	switch (type) {
+		case GL_DEBUG_TYPE_ERROR: return "error";
+		case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated";
+		case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+		case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+		case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+		default: return "other";
+	}
+}
+
+//higher is more severe:
+static uint32_t severity_rank(GLenum severity) {
+	switch (severity) {
+		case GL_DEBUG_SEVERITY_HIGH: return 3;
+		case GL_DEBUG_SEVERITY_MEDIUM: return 2;
+		case GL_DEBUG_SEVERITY_LOW: return 1;
+		default: return 0; //notification
+	}
+}
+
+static char const *severity_name(GLenum severity) {
+	switch (severity) {
+		case GL_DEBUG_SEVERITY_HIGH: return "high";
+		case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+		case GL_DEBUG_SEVERITY_LOW: return "low";
+		default: return "notification";
+	}
+}
+
+static void APIENTRY debug_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *) {
+	if (severity_rank(severity) < severity_rank(gl_debug_min_severity)) return;
+
+	//deduplicate: print a message the first time, then only when its count reaches a power of two:
+	// (without synchronous output, drivers may call this from their own threads, hence the lock)
+	static std::mutex mutex;
+	static std::map< std::tuple< GLenum, GLenum, GLuint >, uint64_t > seen;
+	std::unique_lock< std::mutex > lock(mutex);
+	uint64_t count = ++seen[std::make_tuple(source, type, id)];
+	if ((count & (count - 1)) != 0) return;
+
+	std::string text = (length >= 0 ? std::string(message, length) : std::string(message));
+	while (!text.empty() && (text.back() == '\n' || text.back() == '\r')) text.pop_back();
+	std::cerr << "GL " << severity_name(severity) << " " << type_name(type) << " (" << source_name(source) << ", id " << id << ")";
+	if (count > 1) std::cerr << " [seen " << count << " times]";
+	std::cerr << ": " << text << std::endl;
+}
+
+int gl_debug_init(GLGetProcAddress get_proc_address) {
+	if (!get_proc_address) get_proc_address = [](char const *name) { return SDL_GL_GetProcAddress(name); };
+
+	gl_debug_level = std::max(GL_DEBUG_OFF, std::min(gl_debug_level, int(PONG_GL_DEBUG)));
+	if (gl_debug_level == GL_DEBUG_OFF) return gl_debug_level;
+
+	//prefer KHR_debug (or GL 4.3), fall back to ARB_debug_output:
+	bool khr = false, arb = false;
+	GLint major = 0, minor = 0;
+	glGetIntegerv(GL_MAJOR_VERSION, &major);
+	glGetIntegerv(GL_MINOR_VERSION, &minor);
+	if (major > 4 || (major == 4 && minor >= 3)) khr = true;
+	GLint extensions = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &extensions);
+	for (GLint i = 0; i < extensions; ++i) {
+		char const *name = reinterpret_cast< char const * >(glGetStringi(GL_EXTENSIONS, i));
+		if (std::strcmp(name, "GL_KHR_debug") == 0) khr = true;
+		if (std::strcmp(name, "GL_ARB_debug_output") == 0) arb = true;
+	}
+
+	PFN_glDebugMessageCallback callback = nullptr;
+	PFN_glDebugMessageControl control = nullptr;
+	if (khr) {
+		callback = (PFN_glDebugMessageCallback)get_proc_address("glDebugMessageCallback");
+		control = (PFN_glDebugMessageControl)get_proc_address("glDebugMessageControl");
+	}
+	if (!callback && arb) {
+		khr = false;
+		callback = (PFN_glDebugMessageCallback)get_proc_address("glDebugMessageCallbackARB");
+		control = (PFN_glDebugMessageControl)get_proc_address("glDebugMessageControlARB");
+	}
+	if (!callback) {
+		std::cerr << "NOTE: no KHR_debug or ARB_debug_output; GL debug messages unavailable"
+		          << (gl_debug_level >= GL_DEBUG_FULL ? " (GL_ERRORS() still checks glGetError)." : ".") << std::endl;
+		return gl_debug_level;
+	}
+
+	//(GL_DEBUG_OUTPUT only exists with KHR_debug, and works without a debug context;
+	// ARB_debug_output is always on in a debug context, and may report nothing outside one)
+	if (khr) glEnable(GL_DEBUG_OUTPUT);
+	if (gl_debug_level >= GL_DEBUG_FULL) glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+	else glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+
+	//have the driver skip messages the callback would ignore anyway:
+	if (control) {
+		control(GL_DONT_CARE, GL_DONT_CARE, GL_DONT_CARE, 0, nullptr, GL_TRUE);
+		for (GLenum severity : {GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM}) {
+			if (severity_rank(severity) < severity_rank(gl_debug_min_severity)) {
+				//(ARB_debug_output has no notification severity)
+				if (!khr && severity == GL_DEBUG_SEVERITY_NOTIFICATION) continue;
+				control(GL_DONT_CARE, GL_DONT_CARE, severity, 0, nullptr, GL_FALSE);
+			}
+		}
+	}
+	callback(debug_callback, nullptr);
+
+	return gl_debug_level;
+}
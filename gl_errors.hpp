@@ -2,6 +2,59 @@
 
 #include "GL.hpp"
 #include <iostream>
+#include <string>
+
+/*
+ * OpenGL error reporting, at one of three levels:
+ *
+ *   GL_DEBUG_OFF      -- nothing; GL_ERRORS() does nothing.
+ *   GL_DEBUG_CALLBACK -- the driver reports problems through a KHR_debug /
+ *                        ARB_debug_output callback (asynchronously, so it costs
+ *                        nothing when there are no messages); repeats of a
+ *                        message are counted rather than printed; GL_ERRORS()
+ *                        does nothing.
+ *   GL_DEBUG_FULL     -- as above, but in a debug context, with messages
+ *                        delivered synchronously (during the offending call),
+ *                        and GL_ERRORS() polls glGetError() to report the
+ *                        file:line it was called at. This stalls the driver,
+ *                        so it is opt-in (--gl-debug full), never the default.
+ *
+ * PONG_GL_DEBUG sets the highest level compiled in (default: FULL, or OFF if
+ *  NDEBUG is defined); gl_debug_level picks the level at runtime, up to that
+ *  (default: CALLBACK), and must be set before the context is created.
+ */
+
+#define GL_DEBUG_OFF 0
+#define GL_DEBUG_CALLBACK 1
+#define GL_DEBUG_FULL 2
+
+#ifndef PONG_GL_DEBUG
+	#ifdef NDEBUG
+		#define PONG_GL_DEBUG GL_DEBUG_OFF
+	#else
+		#define PONG_GL_DEBUG GL_DEBUG_FULL
+	#endif
+#endif
+
+//runtime level (clamped to PONG_GL_DEBUG by gl_debug_init; only FULL asks for a debug context):
+extern int gl_debug_level;
+
+//callback messages less severe than this are ignored
+// (GL_DEBUG_SEVERITY_HIGH/MEDIUM/LOW/NOTIFICATION; default LOW, i.e., skip notifications):
+extern GLenum gl_debug_min_severity;
+
+//"off", "callback", "full" -> level (or -1 if not a level name):
+int gl_debug_level_from_string(std::string const &name);
+//"high", "medium", "low", "notification" -> severity (or 0 if not a severity name):
+GLenum gl_debug_severity_from_string(std::string const &name);
+
+//looks up a GL entry point by name (e.g., SDL_GL_GetProcAddress, or OffscreenContext::get_proc_address for EGL contexts):
+typedef void *(*GLGetProcAddress)(char const *name);
+
+//install the debug callback (if gl_debug_level calls for one) on the current context;
+// call once, after init_GL(). The debug entry points are looked up with 'get_proc_address'
+// (default: SDL_GL_GetProcAddress, which only works for SDL-made contexts). Returns the level actually in effect:
+int gl_debug_init(GLGetProcAddress get_proc_address = nullptr);
 
 #define STR2(X) # X
 #define STR(X) STR2(X)
@@ -27,5 +80,10 @@ inline void gl_errors(std::string const &where) {
 		#undef CHECK
 	}
 }
-#define GL_ERRORS() gl_errors(__FILE__  ":" STR(__LINE__) )
 
+#if PONG_GL_DEBUG >= GL_DEBUG_FULL
+	//(glGetError waits for the driver to catch up, so only poll it at the full level)
+	#define GL_ERRORS() do { if (gl_debug_level >= GL_DEBUG_FULL) gl_errors(__FILE__  ":" STR(__LINE__) ); } while (0)
+#else
+	#define GL_ERRORS() do { } while (0)
+#endif
@@ -0,0 +1,173 @@
+//headless.cpp runs Pong of War matches without a window or OpenGL context,
+// as fast as the CPU allows (for balancing and regression runs).
+//Matches are independent, so they are spread over all cores.
+
+//The 'PongSim' struct holds all of the match rules:
+#include "PongSim.hpp"
+
+//Matches run as tasks on a work-stealing pool:
+#include "ThreadPool.hpp"
+
+//for PROFILE_SCOPE and trace export:
+#include "Profiler.hpp"
+
+//...and for c++ standard library functions:
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+int main(int argc, char **argv) {
+	//------------ command line ------------
+
+	uint32_t matches = 1000; //number of matches to play
+	uint32_t seed = 0; //seed of first match; match i uses seed + i
+	float tick_rate = 60.0f; //simulation steps per (simulated) second
+	float max_time = 600.0f; //matches that run longer than this (simulated) time are called a draw
+	uint64_t max_ticks = 0; //if non-zero, matches that run longer than this many ticks are also called a draw
+	float ball_speed_cap = 10.0f; //see PongSim::ball_speed_cap
+	uint32_t threads = 0; //worker threads; 0 means one per hardware thread
+	std::string csv_file = ""; //if set, per-match results are written here
+	std::string trace_file = ""; //if set, a profiler trace (last zones of each thread) is written here
+
+	auto usage = [&]() {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--matches N] [--seed S] [--tick-rate HZ] [--max-time SECONDS] [--max-ticks N] [--ball-speed-cap X] [--threads N] [--csv FILE] [--trace FILE.json]" << std::endl;
+	};
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (argi + 1 >= argc) {
+			usage();
+			return 1;
+		}
+		std::string val = argv[++argi];
+		try {
+			if (arg == "--matches") matches = uint32_t(std::stoul(val));
+			else if (arg == "--seed") seed = uint32_t(std::stoul(val));
+			else if (arg == "--tick-rate") tick_rate = std::stof(val);
+			else if (arg == "--max-time") max_time = std::stof(val);
+			else if (arg == "--max-ticks") max_ticks = std::stoull(val);
+			else if (arg == "--ball-speed-cap") ball_speed_cap = std::stof(val);
+			else if (arg == "--threads") threads = uint32_t(std::stoul(val));
+			else if (arg == "--csv") csv_file = val;
+			else if (arg == "--trace") trace_file = val;
+			else {
+				usage();
+				return 1;
+			}
+		} catch (std::exception const &) {
+			std::cerr << "Bad value '" << val << "' for '" << arg << "'." << std::endl;
+			return 1;
+		}
+	}
+
+	if (!(tick_rate > 0.0f) || !std::isfinite(tick_rate)) {
+		std::cerr << "Tick rate must be positive and finite." << std::endl;
+		return 1;
+	}
+	float const tick = 1.0f / tick_rate; //simulation step, in seconds
+
+	//------------ run matches ------------
+
+	struct Result {
+		uint32_t seed = 0;
+		uint64_t ticks = 0;
+		int winner = 0; //SIDE_LEFT, SIDE_RIGHT, or 0 for a draw
+		int left_health = 0, right_health = 0;
+		uint32_t left_money = 0, right_money = 0;
+		uint32_t left_built = 0, right_built = 0;
+		uint32_t left_score = 0, right_score = 0;
+	};
+	std::vector< Result > results(matches);
+
+	auto play = [&](uint32_t m) {
+		PROFILE_SCOPE("match");
+		Result &result = results[m];
+		result.seed = seed + m;
+
+		PongSim sim(result.seed);
+		sim.left_is_ai = true;
+		sim.ball_speed_cap = ball_speed_cap;
+
+		uint64_t ticks = 0;
+		while (!sim.game_over() && ticks * tick < max_time && (max_ticks == 0 || ticks < max_ticks)) {
+			sim.update(tick);
+			++ticks;
+		}
+
+		result.ticks = ticks;
+		if (!sim.game_over()) result.winner = 0;
+		else if (sim.right_health == 0) result.winner = SIDE_LEFT;
+		else result.winner = SIDE_RIGHT;
+		result.left_health = sim.left_health;
+		result.right_health = sim.right_health;
+		result.left_money = sim.left_money;
+		result.right_money = sim.right_money;
+		result.left_built = sim.left_built;
+		result.right_built = sim.right_built;
+		result.left_score = sim.left_score;
+		result.right_score = sim.right_score;
+	};
+
+	auto before = std::chrono::high_resolution_clock::now();
+
+	uint32_t workers;
+	{
+		ThreadPool pool(threads);
+		workers = pool.size();
+		for (uint32_t m = 0; m < matches; ++m) {
+			pool.submit([m,&play](){ play(m); });
+		}
+		pool.wait();
+	}
+
+	auto after = std::chrono::high_resolution_clock::now();
+	float seconds = std::chrono::duration< float >(after - before).count();
+
+	//------------ report ------------
+
+	uint32_t left_wins = 0;
+	uint32_t right_wins = 0;
+	uint32_t draws = 0;
+	uint64_t total_ticks = 0;
+	for (auto const &result : results) {
+		total_ticks += result.ticks;
+		if (result.winner == SIDE_LEFT) ++left_wins;
+		else if (result.winner == SIDE_RIGHT) ++right_wins;
+		else ++draws;
+	}
+
+	std::cout << "Played " << matches << " matches (" << total_ticks << " ticks) on " << workers << " threads in " << seconds << " seconds." << std::endl;
+	std::cout << "  left wins: " << left_wins << ", right wins: " << right_wins << ", draws: " << draws << std::endl;
+	if (seconds > 0.0f) {
+		std::cout << "  " << (matches / seconds) << " matches/sec, " << (total_ticks / seconds) << " ticks/sec" << std::endl;
+	}
+
+	if (csv_file != "") {
+		std::ofstream csv(csv_file, std::ios::binary);
+		if (!csv) {
+			std::cerr << "Failed to open '" << csv_file << "' for writing." << std::endl;
+			return 1;
+		}
+		csv << "match,seed,ticks,winner,left_health,right_health,left_money,right_money,left_built,right_built,left_score,right_score\n";
+		for (uint32_t m = 0; m < matches; ++m) {
+			Result const &r = results[m];
+			char const *winner = (r.winner == SIDE_LEFT ? "left" : (r.winner == SIDE_RIGHT ? "right" : "draw"));
+			csv << m << ',' << r.seed << ',' << r.ticks << ',' << winner
+				<< ',' << r.left_health << ',' << r.right_health
+				<< ',' << r.left_money << ',' << r.right_money
+				<< ',' << r.left_built << ',' << r.right_built
+				<< ',' << r.left_score << ',' << r.right_score << '\n';
+		}
+		std::cout << "Wrote per-match results to '" << csv_file << "'." << std::endl;
+	}
+
+	if (trace_file != "") {
+		if (!Profiler::write_chrome_trace(trace_file)) return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+#include "image_diff.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_DIFF_SSE2 1
+#endif
+
+static_assert(sizeof(glm::u8vec4) == 4, "pixels should be packed RGBA8");
+
+ImageDiff image_diff(glm::u8vec4 const *a, glm::u8vec4 const *b, size_t count, uint8_t tolerance) {
+	ImageDiff ret;
+	size_t i = 0;
+
+#ifdef IMAGE_DIFF_SSE2
+	__m128i const zero = _mm_setzero_si128();
+	__m128i const tol = _mm_set1_epi8(char(tolerance));
+	__m128i max_delta = zero;
+	for (; i + 4 <= count; i += 4) {
+		__m128i pa = _mm_loadu_si128(reinterpret_cast< __m128i const * >(a + i));
+		__m128i pb = _mm_loadu_si128(reinterpret_cast< __m128i const * >(b + i));
+		//|a - b| per channel (saturating subtracts in both directions, one of which is zero):
+		__m128i delta = _mm_or_si128(_mm_subs_epu8(pa, pb), _mm_subs_epu8(pb, pa));
+		max_delta = _mm_max_epu8(max_delta, delta);
+		//channels within tolerance go to zero; a pixel is fine if all four of its channels did:
+		__m128i over = _mm_subs_epu8(delta, tol);
+		__m128i fine = _mm_cmpeq_epi32(over, zero);
+		int fine_bits = _mm_movemask_ps(_mm_castsi128_ps(fine));
+		int bad_bits = ~fine_bits & 0xf;
+		ret.differing += (bad_bits & 1) + ((bad_bits >> 1) & 1) + ((bad_bits >> 2) & 1) + ((bad_bits >> 3) & 1);
+	}
+	alignas(16) uint8_t lanes[16];
+	_mm_store_si128(reinterpret_cast< __m128i * >(lanes), max_delta);
+	for (uint8_t lane : lanes) {
+		ret.max_delta = std::max(ret.max_delta, lane);
+	}
+#endif
+
+	//(whatever is left, or everything without SSE2)
+	for (; i < count; ++i) {
+		bool differs = false;
+		for (uint32_t c = 0; c < 4; ++c) {
+			uint8_t delta = uint8_t(std::abs(int(a[i][c]) - int(b[i][c])));
+			ret.max_delta = std::max(ret.max_delta, delta);
+			if (delta > tolerance) differs = true;
+		}
+		if (differs) ret.differing += 1;
+	}
+
+	return ret;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * Per-pixel comparison of two RGBA8 images of the same size, for checking
+ *  rendered frames against reference ("golden") images.
+ *
+ * A pixel differs if any of its channels is off by more than 'tolerance'
+ *  (so small rasterization or blending differences between drivers can be
+ *  allowed for). Uses SSE2, four pixels at a time, where available.
+ */
+
+struct ImageDiff {
+	uint64_t differing = 0; //pixels with some channel off by more than the tolerance
+	uint8_t max_delta = 0; //largest difference in any channel of any pixel
+};
+
+ImageDiff image_diff(glm::u8vec4 const *a, glm::u8vec4 const *b, size_t count, uint8_t tolerance);
@@ -9,6 +9,19 @@
 
 //for screenshots:
 #include "load_save_png.hpp"
+#include "FrameCapture.hpp"
+
+//for recording:
+#include "Recorder.hpp"
+
+//for the program binary cache:
+#include "gl_compile_program.hpp"
+
+//for GL debug output:
+#include "gl_errors.hpp"
+
+//for PROFILE_SCOPE and trace export:
+#include "Profiler.hpp"
 
 //Includes for libSDL:
 #include <SDL.h>
@@ -19,6 +32,22 @@
 #include <stdexcept>
 #include <memory>
 #include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+//local time (to the millisecond) for naming screenshots and recordings:
+static std::string timestamp() {
+	auto now = std::chrono::system_clock::now();
+	std::time_t seconds = std::chrono::system_clock::to_time_t(now);
+	uint32_t millis = uint32_t(std::chrono::duration_cast< std::chrono::milliseconds >(now.time_since_epoch()).count() % 1000);
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&seconds));
+	char ret[48];
+	std::snprintf(ret, sizeof(ret), "%s-%03u", stamp, millis);
+	return ret;
+}
 
 int main(int argc, char **argv) {
 #ifdef _WIN32
@@ -26,12 +55,82 @@ int main(int argc, char **argv) {
 	try {
 #endif
 
+	//------------ command line ------------
+
+	//simulation timing:
+	// tick_rate > 0 calls Mode::update in fixed steps of 1/tick_rate seconds, independent of the frame rate;
+	// tick_rate == 0 passes each frame's (clamped) elapsed time straight to Mode::update.
+	float tick_rate = 60.0f;
+	//most fixed steps to run in one frame before giving up on catching up (avoids spiral of death):
+	uint32_t max_ticks_per_frame = 8;
+	//keep linked shader programs on disk between runs (see gl_program_cache_init):
+	bool program_cache = true;
+	//profiler trace file (written when F3 is pressed, and at exit if --trace was given):
+	std::string trace_file = "trace.json";
+	bool trace_at_exit = false;
+	//recording (F4 starts/stops; --record starts at launch):
+	Recorder::Format record_format = Recorder::Y4M;
+	uint32_t record_fps = 60;
+	std::string record_target = "";
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		try {
+			if (arg == "--tick-rate" && argi + 1 < argc) {
+				tick_rate = std::stof(argv[++argi]);
+			} else if (arg == "--max-ticks-per-frame" && argi + 1 < argc) {
+				max_ticks_per_frame = uint32_t(std::stoul(argv[++argi]));
+			} else if (arg == "--vertex-upload" && argi + 1 < argc && std::string(argv[argi+1]) == "ring") {
+				PongMode::vertex_upload = StreamBuffer::Ring;
+				++argi;
+			} else if (arg == "--vertex-upload" && argi + 1 < argc && std::string(argv[argi+1]) == "orphan") {
+				PongMode::vertex_upload = StreamBuffer::Orphan;
+				++argi;
+			} else if (arg == "--gpu-times" && argi + 1 < argc) {
+				PongMode::gpu_times_csv = argv[++argi];
+			} else if (arg == "--trace" && argi + 1 < argc) {
+				trace_file = argv[++argi];
+				trace_at_exit = true;
+			} else if (arg == "--record" && argi + 1 < argc) {
+				record_target = argv[++argi];
+			} else if (arg == "--record-format" && argi + 1 < argc && Recorder::parse_format(argv[argi+1], &record_format)) {
+				++argi;
+			} else if (arg == "--record-fps" && argi + 1 < argc) {
+				record_fps = uint32_t(std::stoul(argv[++argi]));
+			} else if (arg == "--gl-debug" && argi + 1 < argc && gl_debug_level_from_string(argv[argi+1]) >= 0) {
+				gl_debug_level = gl_debug_level_from_string(argv[++argi]);
+			} else if (arg == "--gl-debug-severity" && argi + 1 < argc && gl_debug_severity_from_string(argv[argi+1]) != 0) {
+				gl_debug_min_severity = gl_debug_severity_from_string(argv[++argi]);
+			} else if (arg == "--no-program-cache") {
+				program_cache = false;
+			} else {
+				std::cerr << "Usage:\n\t" << argv[0] << " [--tick-rate HZ] [--max-ticks-per-frame N] [--vertex-upload ring|orphan] [--gpu-times FILE.csv] [--no-program-cache] [--trace FILE.json]\n"
+				             "\t[--gl-debug off|callback|full] [--gl-debug-severity high|medium|low|notification]\n"
+				             "\t[--record FILE|'|COMMAND'] [--record-format y4m|raw|png] [--record-fps N]\n"
+				             "\t(--tick-rate 0 steps the simulation once per frame with a variable timestep)\n"
+				             "\t(--vertex-upload orphan re-uploads vertices with glBufferData every frame instead of using a mapped ring)" << std::endl;
+				return 1;
+			}
+		} catch (std::exception const &) {
+			std::cerr << "Bad value '" << argv[argi] << "' for '" << arg << "'." << std::endl;
+			return 1;
+		}
+	}
+	if (!(tick_rate >= 0.0f) || !std::isfinite(tick_rate) || max_ticks_per_frame == 0) {
+		std::cerr << "Tick rate must be non-negative and finite, and max ticks per frame must be positive." << std::endl;
+		return 1;
+	}
+	if (record_fps == 0) {
+		std::cerr << "Recording rate must be positive." << std::endl;
+		return 1;
+	}
+
 	//------------  initialization ------------
 
 	//Initialize SDL library:
 	SDL_Init(SDL_INIT_VIDEO);
 
-	//Ask for an OpenGL context version 3.3, core profile, enable debug:
+	//Ask for an OpenGL context version 3.3, core profile (with debug output unless it is off):
 	SDL_GL_ResetAttributes();
 	SDL_GL_SetAttribute(SDL_GL_RED_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_GREEN_SIZE, 8);
@@ -41,7 +140,10 @@ int main(int argc, char **argv) {
 	SDL_GL_SetAttribute(SDL_GL_STENCIL_SIZE, 8);
 	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
-	SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+	//(debug contexts can be slower, so only the full level asks for one)
+	if (gl_debug_level >= GL_DEBUG_FULL && PONG_GL_DEBUG >= GL_DEBUG_FULL) {
+		SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS, SDL_GL_CONTEXT_DEBUG_FLAG);
+	}
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
 	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
 
@@ -75,6 +177,19 @@ int main(int argc, char **argv) {
 	//On windows, load OpenGL entrypoints: (does nothing on other platforms)
 	init_GL();
 
+	//Report GL problems at the level chosen above (see gl_errors.hpp):
+	gl_debug_init();
+
+	//Cache linked shader programs in the per-user preferences directory:
+	if (program_cache) {
+		if (char *pref_path = SDL_GetPrefPath("gp21", "pong")) {
+			gl_program_cache_init(pref_path);
+			SDL_free(pref_path);
+		} else {
+			std::cerr << "NOTE: no preferences directory for the program cache (" << SDL_GetError() << ")." << std::endl;
+		}
+	}
+
 	//Set VSYNC + Late Swap (prevents crazy FPS):
 	if (SDL_GL_SetSwapInterval(-1) != 0) {
 		std::cerr << "NOTE: couldn't set vsync + late swap tearing (" << SDL_GetError() << ")." << std::endl;
@@ -86,9 +201,28 @@ int main(int argc, char **argv) {
 	//Hide mouse cursor (note: showing can be useful for debugging):
 	SDL_ShowCursor(SDL_DISABLE);
 
+	//Screenshots are read back and saved in the background (see FrameCapture.hpp):
+	std::unique_ptr< FrameCapture > frame_capture(new FrameCapture());
+	bool screenshot_requested = false;
+
+	//...as is recording:
+	std::unique_ptr< Recorder > recorder;
+	auto start_recording = [&](std::string const &target) {
+		recorder.reset(new Recorder(record_format, target, record_fps));
+		if (!recorder->ok()) {
+			recorder.reset();
+			return;
+		}
+		std::cout << "Recording to '" << target << "' (F4 to stop)." << std::endl;
+	};
+	if (record_target != "") start_recording(record_target);
+
 	//------------ create game mode + make current --------------
 	Mode::set_current(std::make_shared< PongMode >());
 
+	//(every program is built by now, so this covers all of startup)
+	gl_program_cache_report();
+
 	//------------ main loop ------------
 
 	//this inline function will be called whenever the window is resized,
@@ -106,12 +240,16 @@ int main(int argc, char **argv) {
 	};
 	on_resize();
 
+	Profiler::set_thread_name("main");
+
 	//This will loop until the current mode is set to null:
 	while (Mode::current) {
+		PROFILE_SCOPE("frame");
 		//every pass through the game loop creates one frame of output
 		//  by performing three steps:
 
 		{ //(1) process any events that are pending
+			PROFILE_SCOPE("events");
 			static SDL_Event evt;
 			while (SDL_PollEvent(&evt) == 1) {
 				//handle resizing:
@@ -125,50 +263,109 @@ int main(int argc, char **argv) {
 					Mode::set_current(nullptr);
 					break;
 				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_PRINTSCREEN) {
-					// --- screenshot key ---
-					std::string filename = "screenshot.png";
-					std::cout << "Saving screenshot to '" << filename << "'." << std::endl;
-					glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-					glReadBuffer(GL_FRONT);
-					int w,h;
-					SDL_GL_GetDrawableSize(window, &w, &h);
-					std::vector< glm::u8vec4 > data(w*h);
-					glReadPixels(0,0,w,h, GL_RGBA, GL_UNSIGNED_BYTE, data.data());
-					for (auto &px : data) {
-						px.a = 0xff;
-					}
-					save_png(filename, glm::uvec2(w,h), data.data(), LowerLeftOrigin);
+					// --- screenshot key --- (captured after the next draw)
+					screenshot_requested = true;
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F4) {
+					// --- recording key ---
+					if (recorder) recorder.reset(); //(prints a summary)
+					else start_recording("recording-" + timestamp() + Recorder::extension(record_format));
+				} else if (evt.type == SDL_KEYDOWN && evt.key.keysym.sym == SDLK_F3) {
+					// --- profiler trace key ---
+					Profiler::write_chrome_trace(trace_file);
 				}
 			}
 			if (!Mode::current) break;
 		}
 
 		{ //(2) call the current mode's "update" function to deal with elapsed time:
+			PROFILE_SCOPE("update");
 			auto current_time = std::chrono::high_resolution_clock::now();
 			static auto previous_time = current_time;
 			float elapsed = std::chrono::duration< float >(current_time - previous_time).count();
 			previous_time = current_time;
 
-			//if frames are taking a very long time to process,
-			//lag to avoid spiral of death:
-			elapsed = std::min(0.1f, elapsed);
+			if (tick_rate == 0.0f) {
+				//variable timestep:
+				//if frames are taking a very long time to process,
+				//lag to avoid spiral of death:
+				elapsed = std::min(0.1f, elapsed);
+
+				Mode::current->update(elapsed);
+				if (Mode::current) Mode::current->set_tick_fraction(1.0f);
+			} else {
+				//fixed timestep: bank elapsed time and spend it in whole ticks:
+				static float accumulator = 0.0f;
+				float tick = 1.0f / tick_rate;
+				accumulator += elapsed;
+
+				uint32_t ticks = 0;
+				while (accumulator >= tick && ticks < max_ticks_per_frame && Mode::current) {
+					Mode::current->update(tick);
+					accumulator -= tick;
+					++ticks;
+				}
 
-			Mode::current->update(elapsed);
+				//if frames are taking a very long time to process,
+				//drop the time we couldn't catch up on (rather than trying to spend it next frame):
+				if (accumulator >= tick) {
+					static uint32_t dropped_frames = 0;
+					++dropped_frames;
+					if ((dropped_frames & (dropped_frames - 1)) == 0) { //(only report at powers of two to avoid spam)
+						std::cerr << "NOTE: simulation fell behind by " << accumulator << "s and dropped that time (" << dropped_frames << " times so far)." << std::endl;
+					}
+					accumulator = std::fmod(accumulator, tick);
+				}
+
+				//draw this far between the last tick and the next one, so motion stays smooth when ticks are slower than frames:
+				if (Mode::current) Mode::current->set_tick_fraction(std::min(1.0f, accumulator / tick));
+			}
 			if (!Mode::current) break;
 		}
 
 		{ //(3) call the current mode's "draw" function to produce output:
-		
+			PROFILE_SCOPE("draw");
 			Mode::current->draw(drawable_size);
 		}
 
-		//Wait until the recently-drawn frame is shown before doing it all again:
-		SDL_GL_SwapWindow(window);
+		{ //screenshots + recording: start reading back this frame if asked, and pass finished readbacks to the saving threads:
+			PROFILE_SCOPE("capture");
+			if (screenshot_requested) {
+				screenshot_requested = false;
+
+				//timestamped name, so screenshots don't overwrite each other:
+				std::string filename = "screenshot-" + timestamp() + ".png";
+
+				bool started = frame_capture->capture(drawable_size, GL_BACK, [filename](FrameCapture::Frame &frame) {
+					FrameCapture::force_opaque(frame.pixels.data(), frame.pixels.size());
+					save_png(filename, frame.size, frame.pixels.data(), LowerLeftOrigin);
+					std::cout << "Saved screenshot to '" << filename << "'." << std::endl;
+				});
+				if (!started) {
+					std::cerr << "NOTE: still saving earlier screenshots; skipped this one." << std::endl;
+				}
+			}
+			frame_capture->poll();
+
+			if (recorder) recorder->frame(drawable_size);
+		}
+
+		{ //Wait until the recently-drawn frame is shown before doing it all again:
+			PROFILE_SCOPE("swap");
+			SDL_GL_SwapWindow(window);
+		}
+	}
+
+	if (trace_at_exit) {
+		Profiler::write_chrome_trace(trace_file);
 	}
 
 
 	//------------  teardown ------------
 
+	//(finishes any screenshots or recording still being read back or saved)
+	frame_capture.reset();
+	recorder.reset();
+
 	SDL_GL_DeleteContext(context);
 	context = 0;
 
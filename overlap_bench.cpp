@@ -0,0 +1,64 @@
+//overlap_bench.cpp times the aabb_overlap_batch() implementations against each other
+// at a few candidate counts (see aabb_overlap.hpp).
+
+#include "aabb_overlap.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+int main() {
+	std::mt19937 mt(0x12345678);
+	auto rand01 = [&]() { return mt() / float(mt.max()); };
+
+	glm::vec2 const radius = glm::vec2(0.25f, 0.25f);
+
+	std::cout << "candidates  impl     ns/query  ns/candidate  speedup  hits" << std::endl;
+	for (uint32_t count : {16u, 256u, 4096u}) {
+		//candidates scattered over a court-sized area:
+		std::vector< float > xs(count), ys(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			xs[i] = rand01() * 20.0f - 10.0f;
+			ys[i] = rand01() * 10.0f - 5.0f;
+		}
+		//query boxes:
+		std::vector< glm::vec2 > queries(256);
+		for (auto &q : queries) {
+			q = glm::vec2(rand01() * 20.0f - 10.0f, rand01() * 10.0f - 5.0f);
+		}
+		std::vector< uint32_t > hits(count);
+
+		//run each implementation over roughly the same number of candidate tests:
+		uint32_t const rounds = std::max(1u, (1u << 24) / (count * uint32_t(queries.size())));
+
+		double scalar_ns = 0.0;
+		for (AABBOverlapImpl impl : {AABBOverlapScalar, AABBOverlapSSE2, AABBOverlapAVX2}) {
+			if (!aabb_overlap_supported(impl)) {
+				std::cout << std::setw(10) << count << "  " << std::setw(6) << aabb_overlap_name(impl) << "   (not supported)" << std::endl;
+				continue;
+			}
+			uint64_t total_hits = 0;
+			auto before = std::chrono::high_resolution_clock::now();
+			for (uint32_t r = 0; r < rounds; ++r) {
+				for (auto const &q : queries) {
+					total_hits += aabb_overlap_batch(impl, q, radius, xs.data(), ys.data(), count, radius, hits.data());
+				}
+			}
+			auto after = std::chrono::high_resolution_clock::now();
+			double ns = std::chrono::duration< double, std::nano >(after - before).count() / (double(rounds) * queries.size());
+			if (impl == AABBOverlapScalar) scalar_ns = ns;
+
+			std::cout << std::setw(10) << count << "  " << std::setw(6) << aabb_overlap_name(impl)
+			          << "  " << std::setw(9) << std::fixed << std::setprecision(1) << ns
+			          << "  " << std::setw(12) << std::setprecision(3) << ns / count
+			          << "  " << std::setw(6) << std::setprecision(2) << (scalar_ns / ns) << "x"
+			          << "  " << total_hits / rounds << std::endl;
+		}
+	}
+	std::cout << "(aabb_overlap_batch() uses " << aabb_overlap_name(aabb_overlap_best()) << " on this machine)" << std::endl;
+
+	return 0;
+}
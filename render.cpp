@@ -0,0 +1,218 @@
+//render.cpp draws PongMode frames without a window (into an OffscreenContext),
+// for machines with no display (CI, perf boxes): frames can be saved as PNGs,
+// compared against reference ("golden") PNGs, and are timed either way.
+//The left paddle is AI-driven and the match is seeded, so a run is repeatable.
+
+//The 'PongMode' mode draws the game:
+#include "PongMode.hpp"
+
+//windowless GL context + framebuffer:
+#include "OffscreenContext.hpp"
+
+//for saving frames + loading reference images:
+#include "load_save_png.hpp"
+#include "image_diff.hpp"
+
+//for the GL_ERRORS() macro and debug output:
+#include "gl_errors.hpp"
+
+//...and for c++ standard library functions:
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+//"frame-000060.png":
+static std::string frame_name(uint32_t frame, std::string const &suffix = "") {
+	char name[32];
+	std::snprintf(name, sizeof(name), "frame-%06u", frame);
+	return name + suffix + ".png";
+}
+
+int main(int argc, char **argv) {
+	//------------ command line ------------
+
+	glm::uvec2 size = glm::uvec2(640, 480); //framebuffer size (same as the game's initial window)
+	uint32_t frames = 300; //frames to draw
+	uint32_t every = 60; //save/compare every this many frames (frames every, 2*every, ...)
+	uint32_t seed = 0; //match seed
+	float tick = 1.0f / 60.0f; //simulation step, in seconds (one per frame)
+	std::string out_dir = ""; //if set, selected frames (and any failed comparisons) are saved here
+	std::string golden_dir = ""; //if set, selected frames are compared against the same-named PNGs here
+	uint32_t tolerance = 2; //largest per-channel difference that still matches
+	uint64_t max_differing = 0; //most differing pixels a matching frame may have
+
+	auto usage = [&]() {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--size WxH] [--frames N] [--every K] [--seed S] [--tick-rate HZ]\n"
+		             "\t[--out DIR] [--golden DIR] [--tolerance T] [--max-differing N]\n"
+		             "\t[--vertex-upload ring|orphan] [--gpu-times FILE.csv]\n"
+		             "\t[--gl-debug off|callback|full] [--gl-debug-severity high|medium|low|notification]\n"
+		             "\t(frames K, 2K, ... are saved to --out and/or compared with --golden;\n"
+		             "\t a frame matches if at most N pixels have a channel more than T away from the reference)" << std::endl;
+	};
+
+	for (int argi = 1; argi < argc; ++argi) {
+		std::string arg = argv[argi];
+		if (argi + 1 >= argc) {
+			usage();
+			return 1;
+		}
+		std::string val = argv[++argi];
+		try {
+			if (arg == "--size") {
+				size_t x = val.find('x');
+				if (x == std::string::npos) throw std::invalid_argument("no 'x'");
+				size = glm::uvec2(uint32_t(std::stoul(val.substr(0, x))), uint32_t(std::stoul(val.substr(x+1))));
+			}
+			else if (arg == "--frames") frames = uint32_t(std::stoul(val));
+			else if (arg == "--every") every = uint32_t(std::stoul(val));
+			else if (arg == "--seed") seed = uint32_t(std::stoul(val));
+			else if (arg == "--tick-rate") tick = 1.0f / std::stof(val);
+			else if (arg == "--out") out_dir = val;
+			else if (arg == "--golden") golden_dir = val;
+			else if (arg == "--tolerance") tolerance = uint32_t(std::stoul(val));
+			else if (arg == "--max-differing") max_differing = std::stoull(val);
+			else if (arg == "--vertex-upload" && val == "ring") PongMode::vertex_upload = StreamBuffer::Ring;
+			else if (arg == "--vertex-upload" && val == "orphan") PongMode::vertex_upload = StreamBuffer::Orphan;
+			else if (arg == "--gpu-times") PongMode::gpu_times_csv = val;
+			else if (arg == "--gl-debug" && gl_debug_level_from_string(val) >= 0) gl_debug_level = gl_debug_level_from_string(val);
+			else if (arg == "--gl-debug-severity" && gl_debug_severity_from_string(val) != 0) gl_debug_min_severity = gl_debug_severity_from_string(val);
+			else {
+				usage();
+				return 1;
+			}
+		} catch (std::exception const &) {
+			std::cerr << "Bad value '" << val << "' for '" << arg << "'." << std::endl;
+			return 1;
+		}
+	}
+	if (size.x == 0 || size.y == 0 || every == 0 || tolerance > 255 || !(tick > 0.0f)) {
+		std::cerr << "Size, --every, and tick rate must be positive, and tolerance at most 255." << std::endl;
+		return 1;
+	}
+	if (out_dir != "") {
+		mkdir(out_dir.c_str(), 0755); //(if it already exists, that's fine)
+	}
+
+	//------------ initialization ------------
+
+	std::unique_ptr< OffscreenContext > context;
+	try {
+		context.reset(new OffscreenContext(size, gl_debug_level >= GL_DEBUG_FULL && PONG_GL_DEBUG >= GL_DEBUG_FULL));
+	} catch (std::exception const &e) {
+		std::cerr << "Failed to create an offscreen GL context: " << e.what() << std::endl;
+		return 1;
+	}
+	gl_debug_init(OffscreenContext::get_proc_address);
+	std::cout << "Rendering " << size.x << "x" << size.y << " with " << context->description << std::endl;
+
+	std::shared_ptr< PongMode > mode = std::make_shared< PongMode >(seed);
+	mode->sim.left_is_ai = true;
+
+	//------------ draw ------------
+
+	//per-frame times:
+	std::vector< double > cpu_ms; //PongMode::draw() (generating + submitting everything)
+	std::vector< double > frame_ms; //PongMode::draw() + glFinish() (so, also the GPU's share)
+	uint32_t compared = 0, matched = 0, saved = 0;
+	std::vector< glm::u8vec4 > pixels;
+
+	for (uint32_t frame = 1; frame <= frames; ++frame) {
+		if (mode->sim.game_over()) {
+			std::cout << "Match ended after " << (frame - 1) << " frames." << std::endl;
+			break;
+		}
+		mode->sim.update(tick);
+
+		auto before = std::chrono::high_resolution_clock::now();
+		mode->draw(size);
+		auto submitted = std::chrono::high_resolution_clock::now();
+		glFinish();
+		auto after = std::chrono::high_resolution_clock::now();
+		cpu_ms.emplace_back(std::chrono::duration< double, std::milli >(submitted - before).count());
+		frame_ms.emplace_back(std::chrono::duration< double, std::milli >(after - before).count());
+
+		if (frame % every != 0) continue;
+		if (out_dir == "" && golden_dir == "") continue;
+
+		context->read_pixels(&pixels);
+
+		if (out_dir != "") {
+			save_png(out_dir + "/" + frame_name(frame), size, pixels.data(), LowerLeftOrigin);
+			++saved;
+		}
+
+		if (golden_dir != "") {
+			++compared;
+			std::string golden_file = golden_dir + "/" + frame_name(frame);
+			glm::uvec2 golden_size;
+			std::vector< glm::u8vec4 > golden;
+			try {
+				load_png(golden_file, &golden_size, &golden, LowerLeftOrigin);
+			} catch (std::exception const &e) {
+				std::cout << "  frame " << frame << ": FAIL (no reference: " << e.what() << ")" << std::endl;
+				continue;
+			}
+			if (golden_size != size) {
+				std::cout << "  frame " << frame << ": FAIL (reference is " << golden_size.x << "x" << golden_size.y << ")" << std::endl;
+				continue;
+			}
+
+			ImageDiff diff = image_diff(pixels.data(), golden.data(), pixels.size(), uint8_t(tolerance));
+			bool ok = (diff.differing <= max_differing);
+			std::cout << "  frame " << frame << ": " << (ok ? "ok" : "FAIL") << " (" << diff.differing << " pixels differ; max channel difference " << int(diff.max_delta) << ")" << std::endl;
+			if (ok) {
+				++matched;
+			} else if (out_dir != "") {
+				//mark differing pixels in red over a darkened copy of the frame:
+				std::vector< glm::u8vec4 > marked(pixels.size());
+				for (size_t i = 0; i < pixels.size(); ++i) {
+					ImageDiff one = image_diff(&pixels[i], &golden[i], 1, uint8_t(tolerance));
+					if (one.differing) marked[i] = glm::u8vec4(0xff, 0x00, 0x00, 0xff);
+					else marked[i] = glm::u8vec4(pixels[i].r / 4, pixels[i].g / 4, pixels[i].b / 4, 0xff);
+				}
+				save_png(out_dir + "/" + frame_name(frame, "-diff"), size, marked.data(), LowerLeftOrigin);
+			}
+		}
+	}
+
+	GL_ERRORS();
+
+	//------------ report ------------
+
+	auto report = [](char const *label, std::vector< double > times) {
+		if (times.empty()) return;
+		std::sort(times.begin(), times.end());
+		double total = 0.0;
+		for (double t : times) total += t;
+		std::cout << "  " << label << ": mean " << (total / times.size()) << " ms, median " << times[times.size() / 2]
+		          << " ms, max " << times.back() << " ms" << std::endl;
+	};
+	std::cout << "Drew " << cpu_ms.size() << " frames." << std::endl;
+	report("draw (cpu)", cpu_ms);
+	report("draw + finish", frame_ms);
+	std::cout << "  gpu: " << mode->gpu_timer->summary() << std::endl;
+	DrawList::Stats const &stats = mode->draw_list->stats;
+	std::cout << "  last frame: " << stats.draw_calls << " draw calls, " << stats.state_changes << " state changes, "
+	          << stats.vertices << " vertices, " << stats.upload_bytes << " bytes uploaded" << std::endl;
+	if (saved) {
+		std::cout << "Saved " << saved << " frames to '" << out_dir << "'." << std::endl;
+	}
+
+	//(GL objects go before the context does)
+	mode.reset();
+	context.reset();
+
+	if (golden_dir != "") {
+		std::cout << matched << " of " << compared << " frames match '" << golden_dir << "'." << std::endl;
+		if (matched != compared) return 1;
+	}
+
+	return 0;
+}
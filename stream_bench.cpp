@@ -0,0 +1,193 @@
+//stream_bench.cpp compares StreamBuffer::Orphan (glBufferData every frame) against
+// StreamBuffer::Ring (fenced, unsynchronized glMapBufferRange) at a few vertex counts,
+// streaming and drawing PongMode-style rectangles in a hidden window with vsync off.
+
+#include "StreamBuffer.hpp"
+#include "ColorTextureProgram.hpp"
+
+#include "GL.hpp"
+#include "gl_errors.hpp"
+
+#include <SDL.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <new>
+#include <string>
+#include <vector>
+
+//same layout as PongMode::Vertex:
+struct Vertex {
+	Vertex(glm::vec3 const &Position_, glm::u8vec4 const &Color_, glm::vec2 const &TexCoord_) :
+		Position(Position_), Color(Color_), TexCoord(TexCoord_) { }
+	glm::vec3 Position;
+	glm::u8vec4 Color;
+	glm::vec2 TexCoord;
+};
+static_assert(sizeof(Vertex) == 4*3 + 1*4 + 4*2, "Vertex should be packed");
+
+//stream and draw rectangles with each method at a few sizes, printing a table of results:
+static void run(SDL_Window *window, uint32_t frames) {
+	//------------ shared resources ------------
+
+	ColorTextureProgram program;
+
+	GLuint white_tex = 0;
+	glGenTextures(1, &white_tex);
+	glBindTexture(GL_TEXTURE_2D, white_tex);
+	glm::u8vec4 white = glm::u8vec4(0xff, 0xff, 0xff, 0xff);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GL_ERRORS();
+
+	//------------ runs ------------
+
+	std::cout << "rectangles  method  ms/frame  upload ms/frame  MB/s    GPU waits  grows" << std::endl;
+	for (uint32_t rectangles : {100u, 1000u, 10000u, 50000u}) {
+		double orphan_ms = 0.0;
+		for (StreamBuffer::Method method : {StreamBuffer::Orphan, StreamBuffer::Ring}) {
+			StreamBuffer stream(method, sizeof(Vertex));
+
+			GLuint vao = 0;
+			glGenVertexArrays(1, &vao);
+			glBindVertexArray(vao);
+			glBindBuffer(GL_ARRAY_BUFFER, stream.buffer);
+			glVertexAttribPointer(program.Position_vec4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0 + 0);
+			glEnableVertexAttribArray(program.Position_vec4);
+			glVertexAttribPointer(program.Color_vec4, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex), (GLbyte *)0 + 4*3);
+			glEnableVertexAttribArray(program.Color_vec4);
+			glVertexAttribPointer(program.TexCoord_vec2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (GLbyte *)0 + 4*3 + 4*1);
+			glEnableVertexAttribArray(program.TexCoord_vec2);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glBindVertexArray(0);
+
+			uint32_t const warmup = 10;
+			double upload_ms = 0.0;
+			std::chrono::high_resolution_clock::time_point before;
+			uint64_t uploaded_before = 0;
+
+			for (uint32_t frame = 0; frame < warmup + frames; ++frame) {
+				if (frame == warmup) {
+					glFinish();
+					before = std::chrono::high_resolution_clock::now();
+					uploaded_before = stream.bytes_uploaded;
+					upload_ms = 0.0;
+				}
+
+				auto upload_before = std::chrono::high_resolution_clock::now();
+				Vertex *vertices = reinterpret_cast< Vertex * >(stream.map(rectangles * 6 * sizeof(Vertex)));
+				Vertex *end = vertices;
+				float t = frame * 0.01f;
+				for (uint32_t r = 0; r < rectangles; ++r) {
+					//small rectangles scattered over clip space, drifting a bit each frame:
+					glm::vec2 center = glm::vec2(
+						std::fmod(r * 0.618034f + t, 2.0f) - 1.0f,
+						std::fmod(r * 0.381966f + 0.5f * t, 2.0f) - 1.0f
+					);
+					glm::vec2 radius = glm::vec2(0.01f);
+					glm::u8vec4 color = glm::u8vec4(r & 0xff, (r >> 8) & 0xff, 0x80, 0xff);
+					new (end++) Vertex(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+					new (end++) Vertex(glm::vec3(center.x+radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+					new (end++) Vertex(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+					new (end++) Vertex(glm::vec3(center.x-radius.x, center.y-radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+					new (end++) Vertex(glm::vec3(center.x+radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+					new (end++) Vertex(glm::vec3(center.x-radius.x, center.y+radius.y, 0.0f), color, glm::vec2(0.5f, 0.5f));
+				}
+				GLsizei count = GLsizei(end - vertices);
+				GLint first = GLint(stream.unmap(count * sizeof(Vertex)) / sizeof(Vertex));
+				upload_ms += std::chrono::duration< double, std::milli >(std::chrono::high_resolution_clock::now() - upload_before).count();
+
+				glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+				glClear(GL_COLOR_BUFFER_BIT);
+				glUseProgram(program.program);
+				glUniformMatrix4fv(program.OBJECT_TO_CLIP_mat4, 1, GL_FALSE, glm::value_ptr(glm::mat4(1.0f)));
+				glBindVertexArray(vao);
+				glActiveTexture(GL_TEXTURE0);
+				glBindTexture(GL_TEXTURE_2D, white_tex);
+				glDrawArrays(GL_TRIANGLES, first, count);
+				glBindTexture(GL_TEXTURE_2D, 0);
+				glBindVertexArray(0);
+				glUseProgram(0);
+
+				stream.end_frame();
+				SDL_GL_SwapWindow(window);
+			}
+			glFinish();
+			auto after = std::chrono::high_resolution_clock::now();
+
+			double ms = std::chrono::duration< double, std::milli >(after - before).count() / frames;
+			double mb_per_s = (stream.bytes_uploaded - uploaded_before) / (1024.0 * 1024.0) / (ms * frames / 1000.0);
+			if (method == StreamBuffer::Orphan) orphan_ms = ms;
+
+			std::cout << std::setw(10) << rectangles << "  " << std::setw(6) << (method == StreamBuffer::Orphan ? "orphan" : "ring")
+			          << "  " << std::setw(8) << std::fixed << std::setprecision(3) << ms
+			          << "  " << std::setw(15) << upload_ms / frames
+			          << "  " << std::setw(7) << std::setprecision(1) << mb_per_s
+			          << "  " << std::setw(9) << stream.waits
+			          << "  " << std::setw(5) << stream.grows;
+			if (method == StreamBuffer::Ring) {
+				std::cout << "  (" << std::setprecision(2) << orphan_ms / ms << "x vs. orphan)";
+			}
+			std::cout << std::endl;
+
+			glDeleteVertexArrays(1, &vao);
+			GL_ERRORS();
+		}
+	}
+
+	glDeleteTextures(1, &white_tex);
+}
+
+int main(int argc, char **argv) {
+	uint32_t frames = 500; //timed frames per run (after a few warm-up frames)
+	if (argc == 3 && std::string(argv[1]) == "--frames") {
+		frames = uint32_t(std::stoul(argv[2]));
+	} else if (argc != 1) {
+		std::cerr << "Usage:\n\t" << argv[0] << " [--frames N]" << std::endl;
+		return 1;
+	}
+
+	//------------ GL context (hidden window) ------------
+
+	SDL_Init(SDL_INIT_VIDEO);
+
+	SDL_GL_ResetAttributes();
+	SDL_GL_SetAttribute(SDL_GL_DOUBLEBUFFER, 1);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
+	SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
+
+	SDL_Window *window = SDL_CreateWindow("stream bench", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+		640, 480, SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+	if (!window) {
+		std::cerr << "Error creating SDL window: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+	SDL_GLContext context = SDL_GL_CreateContext(window);
+	if (!context) {
+		SDL_DestroyWindow(window);
+		std::cerr << "Error creating OpenGL context: " << SDL_GetError() << std::endl;
+		return 1;
+	}
+	init_GL();
+	SDL_GL_SetSwapInterval(0); //measure the upload, not the display
+
+	std::cout << "GL_RENDERER: " << glGetString(GL_RENDERER) << std::endl;
+
+	run(window, frames);
+
+	//------------ teardown ------------
+
+	SDL_GL_DeleteContext(context);
+	SDL_DestroyWindow(window);
+
+	return 0;
+}